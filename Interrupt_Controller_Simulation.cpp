@@ -5,259 +5,660 @@ Language: C++ (C++17)
 Features:
 - Simulates three I/O devices: Keyboard (high), Mouse (medium), Printer (low)
 - Each device runs a thread that periodically generates interrupts (randomized delays)
+- Pluggable arrival models per device: uniform, Poisson, on/off bursts, periodic, Pareto, trace
+- ISR service-time models (constant, exponential, lognormal, empirical), optionally burned as real CPU work
+- Spin mode for microsecond-scale interrupt rates: lock-free rings, busy-waiting
+- Thread placement: per-thread CPU pinning, SCHED_FIFO priorities, an isolated controller core;
+  the placement each thread actually got is shown by "status" and in the final report
+- Optional hardware counters (cycles, instructions, cache/branch misses) per ISR and for selection
+- Optional live metrics in Prometheus text format on a Unix domain socket
 - Central Interrupt Controller serves highest-priority pending interrupt that is not masked
 - Supports runtime masking/unmasking of devices through simple console commands
+- APIC-style priority classes: a task priority register per controller CPU holds back every
+  device class at or below its level with one write
+- Scriptable control plane: the same commands over a Unix socket or a stdin pipe (epoll event loop)
+- Scenario files: timed commands and latency expectations, replayed in real or virtual time
+- What-if branching: fork a virtual-time run and compare alternative futures in parallel
+- Shared-memory ingress: separate generator processes (interrupt_gen) can raise interrupts
 - Prints clear messages for ISR handling and masked interrupts
 - Optional logging: records ISR start time and completion time to "isr_log.txt"
-
-Compile:
-    g++ -std=c++17 -pthread Interrupt_Controller_Simulation.cpp -o interrupt_sim
+- Optional TSC timestamping, with wall-time formatting deferred to the log tool
+- Log rotation by size and/or interval; closed segments are compressed in the background
+- Optional Chrome Trace Event export (open in chrome://tracing or ui.perfetto.dev)
+
+The controller itself lives in the ics library (ics/interrupt_controller.h);
+this file is the console front end.
+
+Build (CMake presets: release, native, debug, tsan, asan):
+    cmake --preset release && cmake --build --preset release
+    # targets: interrupt_sim, interrupt_bench, interrupt_sweep, interrupt_gen, isr_log_tool,
+    #          interrupt_coro (C++20)
+    # (binaries in build/<preset>/)
 Run:
-    ./interrupt_sim
+    ./interrupt_sim [options]
+
+Options:
+    --log-max-bytes N   -- rotate isr_log.txt once it grows past N bytes
+    --log-rotate-sec S  -- rotate isr_log.txt every S seconds
+    --no-compress       -- keep closed segments as plain text
+    --trace FILE        -- write ISR/queue-wait spans as Chrome Trace Event JSON
+    --arrival D=SPEC    -- arrival model for device D (k|m|p), e.g. k=poisson:rate=5,
+                           p=onoff:rate=2,on=0.05,off=1 or m=trace:file=gaps.txt (see ics/arrival.h)
+    --service D=SPEC    -- ISR service-time model for device D, e.g. k=exp:ms=300,
+                           p=lognormal:ms=800,sigma=1 or m=empirical:file=isr_ns.txt (see ics/service.h)
+    --isr-work W        -- sleep (default), compute (busy integer kernel) or memory (cache-missing
+                           pointer chase); the latter two are calibrated at startup and run on the CPU
+    --spin              -- low-latency mode: device and controller threads busy-wait on lock-free rings
+                           and the run ends with a latency report instead of per-ISR output. Defaults
+                           to Poisson 100k interrupts/s per device and 1 us ISRs (override with
+                           --arrival/--service); no log or trace is written
+    --duration SEC      -- spin mode run length (default 10)
+    --workers N         -- spin mode: shard dispatch by IRQ line across N controller workers (1-3); a shared
+                           priority summary word keeps higher-priority lines served first. Spin mode is
+                           the only sharded path: the threaded controller always dispatches on one thread
+    --tpr L[,L...]      -- initial task priority register (0-15): interrupts of class <= L stay pending
+                           (classes: Printer 1, Mouse 2, Keyboard 3). In spin mode one level per worker
+                           CPU, the last repeated; otherwise the controller's (and --virtual's) level
+    --cpus C,K,M,P      -- pin controller, Keyboard, Mouse, Printer threads to these CPUs (-1 = unpinned)
+    --input-cpu N       -- pin the console input thread to CPU N
+    --rt-priority N     -- run the controller under SCHED_FIFO at priority N (1-99) and device threads
+                           at N-1; needs CAP_SYS_NICE or an rtprio limit, otherwise reported as refused.
+                           In spin mode keep spinning threads on cores of their own, or they can
+                           starve lower-priority work until the kernel's RT throttling kicks in
+    --isolate-controller -- keep every other simulator thread off the controller's CPU
+                           (requires the controller to be pinned with --cpus)
+    --perf              -- count cycles, instructions, cache misses and branch misses per ISR and
+                           per selection on the controller thread (perf_event_open; shown as
+                           unavailable where perf events are not permitted)
+    --tsc               -- timestamp interrupts and ISRs with the invariant TSC (calibrated at startup)
+                           and log them as raw steady-clock times, converted to wall time offline
+                           by "./isr_log_tool cat"; falls back to steady_clock without an invariant TSC
+    --metrics-socket P  -- serve per-device counters, queue depth and latency quantiles in Prometheus
+                           format on Unix socket P, e.g. curl --unix-socket P http://localhost/metrics
+    --control-socket P  -- accept commands on Unix socket P, one per line, one "ok ..."/"err ..." reply
+                           per command (see ics/control.h); e.g. printf 'mask k\nstatus\n' | nc -U P
+    --control-stdin     -- speak that protocol on stdin/stdout instead of the console (ISR messages off),
+                           for driving the simulator from a pipe
+    --scenario FILE     -- run the timed commands in FILE instead of reading the console, then check its
+                           expectations and exit 1 if any is violated (format: see ics/scenario.h);
+                           not with --spin
+    --virtual           -- with --scenario: replay in virtual time (discrete-event Simulation, instant)
+    --seed N            -- with --virtual: random seed (default 1), so regression runs are repeatable
+    --save-checkpoint F -- with --virtual: save the complete simulation state at the end of the run to F
+    --resume F          -- with --virtual: continue from checkpoint F instead of starting empty; the
+                           scenario's times count from the checkpoint and its settings apply from there;
+                           not with --tpr, the checkpoint carries its own
+    --branch F          -- with --virtual, repeatable: after the run, fork its final state once per file
+                           and play each scenario F from there in parallel, then compare their latencies
+                           and expectations (measured from the fork; see ics/whatif.h)
+    --shm-ingress NAME  -- also accept interrupts from other processes through shared-memory ring NAME
+                           (e.g. /ics_ingress); see interrupt_gen.cpp
+
+Closed segments are named isr_log.txt.1, isr_log.txt.2, ... and compressed to
+isr_log.txt.N.icz; read them back, oldest first, with "./isr_log_tool cat isr_log.txt.* isr_log.txt".
 
 Console commands (type while program is running):
     mask k|m|p      -- mask Keyboard/Mouse/Printer
     unmask k|m|p    -- unmask device
-    status          -- show masked/unmasked and pending counts
+    status          -- show masked/unmasked, the TPR and pending counts
+    perf            -- show hardware counter averages (with --perf)
+    set-rate D HZ   -- change device D's mean interrupt rate
+    set-policy P    -- switch scheduling policy: priority, fifo or rr
+    tpr L           -- set the controller CPU's task priority register (0 accepts all, 3 blocks all)
     exit            -- stop simulation and exit cleanly
 
 Note: This is a simulation for educational purposes (ISR work is represented by delays).
 */
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <thread>
-#include <mutex>
-#include <condition_variable>
+#include <utility>
 #include <vector>
-#include <atomic>
-#include <random>
-#include <fstream>
 #include <sstream>
-#include <iomanip>
-#include <chrono>
 #include <string>
-#include <climits>
-#include <ctime>
+#include <cstdlib>
+
+#include "ics/checkpoint.h"
+#include "ics/command_server.h"
+#include "ics/console_sink.h"
+#include "ics/control.h"
+#include "ics/interrupt_controller.h"
+#include "ics/isr_log.h"
+#include "ics/metrics_server.h"
+#include "ics/scenario.h"
+#include "ics/shm_ring.h"
+#include "ics/spin_controller.h"
+#include "ics/trace_sink.h"
+#include "ics/whatif.h"
 
+using namespace std;
+using namespace ics;
+
+bool parse_device(const string &which, Device &dev) {
+    if (which == "k") dev = KEYBOARD;
+    else if (which == "m") dev = MOUSE;
+    else if (which == "p") dev = PRINTER;
+    else return false;
+    return true;
+}
 
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <atomic>
+// "TPR 2 (holds back Printer, Mouse)"
+string describe_tpr(int tpr) {
+    string blocked;
+    for (Device d : {PRINTER, MOUSE, KEYBOARD})
+        if (priority_class(d) <= tpr) blocked += (blocked.empty() ? "" : ", ") + device_name(d);
+    return "TPR " + to_string(tpr) + (blocked.empty() ? " (accepts all)" : " (holds back " + blocked + ")");
+}
 
-using namespace std;
+string describe_cpu(int cpu) {
+    return cpu >= 0 ? "cpu " + to_string(cpu) : "cpu ?";
+}
 
-enum Device { PRINTER = 1, MOUSE = 2, KEYBOARD = 3 };
+void print_status(ostream &out, const InterruptController &ic) {
+    ControllerStatus st = ic.status();
+    out << "Status:\n";
+    out << "  Keyboard: " << (st.masked[KEYBOARD]?"Masked":"Unmasked") << "\n";
+    out << "  Mouse:    " << (st.masked[MOUSE]?"Masked":"Unmasked") << "\n";
+    out << "  Printer:  " << (st.masked[PRINTER]?"Masked":"Unmasked") << "\n";
+    out << "  Task priority: controller " << describe_cpu(st.cpu) << " " << describe_tpr(st.tpr) << "\n";
+    out << "  Pending interrupts: " << st.pending << "\n";
+    out << "  Policy: " << policy_name(ic.policy()) << "\n";
+}
 
-struct InterruptEvent {
-    Device dev;
-    long long seq; // sequence number to break ties (older first)
-    chrono::steady_clock::time_point timestamp;
-};
+void print_placement(ostream &out, const vector<PlacementRecord> &records) {
+    out << "Thread placement:\n";
+    for (const PlacementRecord &r : records) out << "  " << format_placement(r) << "\n";
+}
 
-// shared state
-mutex mtx;
-condition_variable cv;
-vector<InterruptEvent> pending; // small list; we'll search for highest-priority unmasked
-atomic<bool> running{true};
+void print_perf_row(ostream &out, const string &label, const PerfTotals &t, const PerfReport &r) {
+    out << "  " << left << setw(12) << label << right << setw(10) << t.sections;
+    for (int c = 0; c < PERF_COUNTERS; ++c) {
+        if (r.counter_available[c]) out << setw(16) << fixed << setprecision(0) << t.per_section(c);
+        else out << setw(16) << "unavailable";
+    }
+    double cycles = t.per_section(PERF_CYCLES);
+    if (r.counter_available[PERF_INSTRUCTIONS] && cycles > 0)
+        out << setw(8) << setprecision(2) << t.per_section(PERF_INSTRUCTIONS) / cycles;
+    out << "\n";
+}
 
-bool masked_keyboard = false;
-bool masked_mouse = false;
-bool masked_printer = false;
+void print_perf(ostream &out, const PerfReport &r) {
+    if (!r.enabled) {
+        out << "Hardware counters: off (start with --perf)\n";
+        return;
+    }
+    if (!r.available) {
+        out << "Hardware counters: unavailable (" << r.error << ")\n";
+        return;
+    }
+    out << "Hardware counters (user space, average per section):\n";
+    out << "  " << left << setw(12) << "Section" << right << setw(10) << "count";
+    for (int c = 0; c < PERF_COUNTERS; ++c) out << setw(16) << perf_counter_name(c);
+    out << setw(8) << "IPC" << "\n";
+    print_perf_row(out, "selection", r.selection, r);
+    for (Device d : ALL_DEVICES) print_perf_row(out, device_name(d) + " ISR", r.isr[d], r);
+    if (!r.error.empty()) out << "  (" << r.error << ")\n";
+}
 
-long long global_seq = 0;
+// Prints each expectation's outcome; returns false if any failed
+bool report_expectations(const vector<ExpectationResult> &results) {
+    bool ok = true;
+    if (!results.empty()) cout << "Expectations:\n";
+    for (const ExpectationResult &r : results) {
+        cout << "  " << format_expectation(r) << "\n";
+        ok = ok && r.ok;
+    }
+    cout << (ok ? "Scenario passed" : "Scenario FAILED") << endl;
+    return ok;
+}
 
-// logging
-mutex log_mtx;
-string log_filename = "isr_log.txt";
+// One row per branch: per-device p99 and dispatch count over the branch's window
+void print_branches(const vector<BranchOutcome> &outcomes, int64_t fork_ns) {
+    cout << "What-if branches from " << fixed << setprecision(2) << fork_ns / 1e9 << " s:\n";
+    size_t width = 6;
+    for (const BranchOutcome &o : outcomes) width = max(width, o.name.size());
+    cout << "  " << left << setw((int)width) << "branch" << right;
+    for (Device d : ALL_DEVICES) cout << setw(14) << string(device_name(d)) + " p99" << setw(10) << "served";
+    cout << "  expectations\n";
+    for (const BranchOutcome &o : outcomes) {
+        cout << "  " << left << setw((int)width) << o.name << right;
+        for (Device d : ALL_DEVICES) {
+            const DeviceStats &s = o.result.devices[d];
+            cout << setw(11) << s.latency.quantile(0.99) / 1e6 << " ms" << setw(10) << s.dispatched;
+        }
+        size_t passed = 0;
+        for (const ExpectationResult &r : o.expectations) passed += r.ok;
+        cout << "  " << passed << "/" << o.expectations.size() << " ok\n";
+        if (!o.error.empty()) cout << "    rejected " << o.error << "\n";
+        for (const ExpectationResult &r : o.expectations)
+            if (!r.ok) cout << "    " << format_expectation(r) << "\n";
+    }
+}
+
+// Trace track for the controller's ISRs: its CPU when pinned, otherwise just
+// "controller" (an unpinned thread can migrate between CPUs)
+string controller_track(const InterruptController &ic, const ThreadPlacement &placement) {
+    int cpu = ic.status().cpu;
+    return placement.cpu >= 0 && cpu >= 0 ? "CPU " + to_string(cpu) : "controller";
+}
+
+// "k=SPEC" -> device + spec text
+bool split_device_spec(const string &arg, Device &dev, string &spec) {
+    if (arg.size() < 3 || arg[1] != '=' || !parse_device(arg.substr(0, 1), dev)) return false;
+    spec = arg.substr(2);
+    return true;
+}
 
-void append_log(const string &line) {
-    lock_guard<mutex> lg(log_mtx);
-    ofstream f(log_filename, ios::app);
-    if(f) {
-        f << line << "\n";
+// Console commands: the human-readable layer over the control protocol (ics/control.h)
+string console_command(InterruptController &ic, const string &line, const PlacementRecord &input, bool &exit) {
+    stringstream ss(line), out;
+    string token;
+    if (!(ss >> token)) return "";
+    if (token == "mask" || token == "unmask") {
+        string which; ss >> which;
+        Device dev;
+        if (!parse_device(which, dev)) return "Unknown device. Use k/m/p.";
+        ic.set_mask(dev, token == "mask");
+        return device_name(dev) + " " + token + "ed.";
+    } else if (token == "status") {
+        print_status(out, ic);
+        vector<PlacementRecord> placement = ic.placement();
+        placement.push_back(input);
+        print_placement(out, placement);
+    } else if (token == "perf") {
+        print_perf(out, ic.perf_report());
+    } else if (token == "exit") {
+        exit = true;
+        return "Exiting...";
+    } else if (token == "set-rate" || token == "set-policy" || token == "tpr") {
+        return execute_command(ic, line, exit);
+    } else {
+        return "Commands: mask k|m|p, unmask k|m|p, status, perf, set-rate k|m|p HZ, set-policy priority|fifo|rr, "
+               "tpr 0-15, exit";
     }
+    string text = out.str();
+    if (!text.empty() && text.back() == '\n') text.pop_back();
+    return text;
 }
 
-string device_name(Device d) {
-    switch(d) {
-        case KEYBOARD: return "Keyboard";
-        case MOUSE: return "Mouse";
-        case PRINTER: return "Printer";
+void print_spin_report(const SpinReport &r) {
+    cout << fixed << setprecision(1);
+    cout << "Spin mode report (" << r.seconds << " s, latency = raise to ISR start):\n";
+    cout << "  " << left << setw(10) << "Device" << right << setw(12) << "arrivals" << setw(12) << "dispatched"
+         << setw(10) << "dropped" << setw(12) << "per sec" << setw(10) << "p50 us" << setw(10) << "p99 us"
+         << setw(10) << "p99.9 us" << setw(12) << "max us" << "\n";
+    uint64_t total = 0;
+    for (Device d : ALL_DEVICES) {
+        const DeviceStats &s = r.devices[d];
+        total += s.dispatched;
+        cout << "  " << left << setw(10) << device_name(d) << right << setw(12) << s.arrivals << setw(12) << s.dispatched
+             << setw(10) << s.dropped << setw(12) << (r.seconds > 0 ? s.dispatched / r.seconds : 0)
+             << setw(10) << s.latency.quantile(0.50) / 1e3 << setw(10) << s.latency.quantile(0.99) / 1e3
+             << setw(10) << s.latency.quantile(0.999) / 1e3 << setw(12) << s.latency.max() / 1e3 << "\n";
+    }
+    cout << "  Total dispatch rate: " << (r.seconds > 0 ? total / r.seconds : 0) << " interrupts/s\n";
+    cout << "  Idle controller polls: " << r.idle_polls << endl;
+    if (r.workers > 1)
+        cout << "  Controller workers: " << r.workers << ", polls deferred to higher priority elsewhere: " << r.deferrals << endl;
+    for (size_t w = 0; w < r.tpr.size(); ++w) {
+        string role = r.workers > 1 ? "controller " + to_string(w) : "controller";
+        int cpu = -1;
+        for (const PlacementRecord &p : r.placement)
+            if (p.role == role) cpu = p.cpu;
+        cout << "  Task priority: " << role << " " << describe_cpu(cpu) << " " << describe_tpr(r.tpr[w]) << endl;
     }
-    return "Unknown";
 }
 
-// Device thread function: generate interrupts periodically (randomized)
-void device_thread(Device dev, int min_ms, int max_ms) {
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> dist(min_ms, max_ms);
-
-    while (running) {
-        int wait_ms = dist(gen);
-        this_thread::sleep_for(chrono::milliseconds(wait_ms));
-        if(!running) break;
-
-        // push interrupt
-        {
-            lock_guard<mutex> lg(mtx);
-            pending.push_back({dev, ++global_seq, chrono::steady_clock::now()});
-        }
-        cv.notify_one();
+// "L[,L...]" -> task priority levels, each 0 to MAX_TPR
+bool parse_tpr_list(const string &list, vector<int> &levels) {
+    stringstream ss(list);
+    string item;
+    levels.clear();
+    while (getline(ss, item, ',')) {
+        int level;
+        if (!parse_tpr(item, level)) return false;
+        levels.push_back(level);
     }
+    return !levels.empty();
 }
 
-// Interrupt Controller: pick highest-priority unmasked interrupt and run its ISR
-void controller_thread() {
-    while (running) {
-        unique_lock<mutex> ul(mtx);
-        cv.wait(ul, []{ return !pending.empty() || !running; });
-        if(!running && pending.empty()) break;
-
-        // find highest-priority pending event that is not masked
-        int best_idx = -1;
-        Device best_dev = PRINTER;
-        long long best_seq = LLONG_MAX;
-        for (int i = 0; i < (int)pending.size(); ++i) {
-            Device d = pending[i].dev;
-            bool is_masked = (d == KEYBOARD && masked_keyboard) ||
-                             (d == MOUSE && masked_mouse) ||
-                             (d == PRINTER && masked_printer);
-            if (is_masked) continue;
-            // priority: KEYBOARD (3) > MOUSE (2) > PRINTER (1)
-            if (best_idx == -1 || pending[i].dev > best_dev || (pending[i].dev == best_dev && pending[i].seq < best_seq)) {
-                best_idx = i;
-                best_dev = pending[i].dev;
-                best_seq = pending[i].seq;
-            }
-        }
+// "C,K,M,P" -> controller and per-device CPUs
+bool parse_cpus(const string &list, ThreadPlacement &controller, array<ThreadPlacement, DEVICE_SLOTS> &devices) {
+    stringstream ss(list);
+    string item;
+    int values[4], n = 0;
+    while (getline(ss, item, ',')) {
+        if (n == 4 || item.empty()) return false;
+        values[n++] = atoi(item.c_str());
+    }
+    if (n != 4) return false;
+    controller.cpu = values[0];
+    devices[KEYBOARD].cpu = values[1];
+    devices[MOUSE].cpu = values[2];
+    devices[PRINTER].cpu = values[3];
+    return true;
+}
 
-        if (best_idx == -1) {
-            // all pending are masked - print ignored messages and just wait until masks change or new interrupts
-            // To avoid busy waiting, wait on cv until masks change or new unmasked interrupt arrives.
-            // But we'll also print masked status for visibility.
-            for (auto &ev : pending) {
-                Device d = ev.dev;
-                bool is_masked = (d == KEYBOARD && masked_keyboard) ||
-                                 (d == MOUSE && masked_mouse) ||
-                                 (d == PRINTER && masked_printer);
-                if (is_masked) {
-                    cout << device_name(d) << " Interrupt Ignored (Masked)" << endl;
-                }
-            }
-            // wait for mask change or new events
-            cv.wait_for(ul, chrono::milliseconds(200));
-            continue;
+int main(int argc, char **argv) {
+    LogOptions log_options;
+    ControllerConfig config;
+    string trace_path, metrics_socket, control_socket;
+    bool control_stdin = false;
+    string scenario_path;
+    bool virtual_time = false;
+    uint64_t seed = 1;
+    string shm_ingress, checkpoint_path, resume_path;
+    vector<string> branch_paths;
+    bool spin = false;
+    double duration_s = 10;
+    int spin_workers = 1;
+    string tpr_list;
+    string cpus;
+    int input_cpu = -1, rt_priority = 0;
+    bool isolate_controller = false;
+    vector<pair<string, string>> model_args; // applied once the mode (and so the defaults) is known
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--log-max-bytes" && i + 1 < argc) log_options.max_bytes = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--log-rotate-sec" && i + 1 < argc) log_options.rotate_sec = atoi(argv[++i]);
+        else if (arg == "--no-compress") log_options.compress = false;
+        else if (arg == "--trace" && i + 1 < argc) trace_path = argv[++i];
+        else if ((arg == "--arrival" || arg == "--service") && i + 1 < argc) model_args.push_back({arg, argv[++i]});
+        else if (arg == "--isr-work" && i + 1 < argc && parse_isr_work(argv[i + 1], config.work)) ++i;
+        else if (arg == "--spin") spin = true;
+        else if (arg == "--duration" && i + 1 < argc) duration_s = atof(argv[++i]);
+        else if (arg == "--workers" && i + 1 < argc) spin_workers = atoi(argv[++i]);
+        else if (arg == "--tpr" && i + 1 < argc) tpr_list = argv[++i];
+        else if (arg == "--cpus" && i + 1 < argc) cpus = argv[++i];
+        else if (arg == "--input-cpu" && i + 1 < argc) input_cpu = atoi(argv[++i]);
+        else if (arg == "--rt-priority" && i + 1 < argc) rt_priority = atoi(argv[++i]);
+        else if (arg == "--isolate-controller") isolate_controller = true;
+        else if (arg == "--perf") config.perf_counters = true;
+        else if (arg == "--tsc") {
+            config.time_source = TimeSource::TSC;
+            log_options.raw_time = true;
         }
-
-        // extract event
-        InterruptEvent ev = pending[best_idx];
-        pending.erase(pending.begin() + best_idx);
-        ul.unlock();
-
-        // handle ISR
-        auto now = chrono::system_clock::now();
-        time_t start_time = chrono::system_clock::to_time_t(now);
-        cout << device_name(ev.dev) << " Interrupt Triggered → Handling ISR → ";
-        cout << "Started at " << put_time(localtime(&start_time), "%F %T") << endl;
-
-        // log start
-        {
-            stringstream ss;
-            ss << "START | " << device_name(ev.dev) << " | seq=" << ev.seq << " | "
-               << put_time(localtime(&start_time), "%F %T");
-            append_log(ss.str());
+        else if (arg == "--metrics-socket" && i + 1 < argc) metrics_socket = argv[++i];
+        else if (arg == "--control-socket" && i + 1 < argc) control_socket = argv[++i];
+        else if (arg == "--control-stdin") control_stdin = true;
+        else if (arg == "--scenario" && i + 1 < argc) scenario_path = argv[++i];
+        else if (arg == "--virtual") virtual_time = true;
+        else if (arg == "--seed" && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--shm-ingress" && i + 1 < argc) shm_ingress = argv[++i];
+        else if (arg == "--save-checkpoint" && i + 1 < argc) checkpoint_path = argv[++i];
+        else if (arg == "--resume" && i + 1 < argc) resume_path = argv[++i];
+        else if (arg == "--branch" && i + 1 < argc) branch_paths.push_back(argv[++i]);
+        else {
+            cerr << "Usage: " << argv[0] << " [--log-max-bytes N] [--log-rotate-sec S] [--no-compress] [--trace FILE]\n"
+                 << "       [--arrival D=SPEC]... [--service D=SPEC]... [--isr-work sleep|compute|memory]\n"
+                 << "       [--spin [--duration SEC] [--workers N]] [--tpr L[,L...]] [--cpus C,K,M,P] [--input-cpu N]\n"
+                 << "       [--rt-priority N] [--isolate-controller] [--perf] [--tsc] [--metrics-socket PATH]\n"
+                 << "       [--control-socket PATH] [--control-stdin] [--scenario FILE [--virtual [--seed N] [--save-checkpoint FILE]\n"
+                 << "       [--resume FILE] [--branch FILE]...]] [--shm-ingress NAME]" << endl;
+            return 1;
         }
+    }
 
-        // Simulate ISR work (vary by device)
-        if (ev.dev == KEYBOARD) this_thread::sleep_for(chrono::milliseconds(300));
-        else if (ev.dev == MOUSE) this_thread::sleep_for(chrono::milliseconds(500));
-        else this_thread::sleep_for(chrono::milliseconds(800));
-
-        auto done = chrono::system_clock::now();
-        time_t done_time = chrono::system_clock::to_time_t(done);
-        cout << device_name(ev.dev) << " ISR Completed at " << put_time(localtime(&done_time), "%F %T") << endl;
-
-        // log completion
-        {
-            stringstream ss;
-            ss << "END   | " << device_name(ev.dev) << " | seq=" << ev.seq << " | "
-               << put_time(localtime(&done_time), "%F %T");
-            append_log(ss.str());
+    ThreadPlacement controller_thread, input_thread;
+    array<ThreadPlacement, DEVICE_SLOTS> device_threads{};
+    input_thread.cpu = input_cpu;
+    if (!cpus.empty() && !parse_cpus(cpus, controller_thread, device_threads)) {
+        cerr << "--cpus expects four CPU numbers: controller,keyboard,mouse,printer" << endl;
+        return 1;
+    }
+    vector<int> tpr_levels;
+    if (!tpr_list.empty() && !parse_tpr_list(tpr_list, tpr_levels)) {
+        cerr << "--tpr expects levels 0-" << MAX_TPR << ", comma-separated" << endl;
+        return 1;
+    }
+    if (!tpr_levels.empty()) config.tpr = tpr_levels[0];
+    if (!tpr_levels.empty() && !resume_path.empty()) {
+        cerr << "--tpr cannot be combined with --resume: the checkpoint carries its own TPR" << endl;
+        return 1;
+    }
+    if (spin_workers < 1 || spin_workers > DEVICE_SLOTS - 1) {
+        cerr << "--workers expects 1-" << DEVICE_SLOTS - 1 << ", one worker per IRQ line at most" << endl;
+        return 1;
+    }
+    if (spin_workers > 1 && !spin) {
+        cerr << "--workers needs --spin: the threaded controller has a single dispatch thread" << endl;
+        return 1;
+    }
+    if (spin && !scenario_path.empty()) {
+        cerr << "--scenario cannot be combined with --spin" << endl;
+        return 1;
+    }
+    if (rt_priority < 0 || rt_priority > 99) {
+        cerr << "--rt-priority expects 1-99" << endl;
+        return 1;
+    }
+    if (rt_priority > 0) {
+        controller_thread.fifo_priority = rt_priority;
+        for (Device d : ALL_DEVICES) device_threads[d].fifo_priority = rt_priority > 1 ? rt_priority - 1 : 1;
+    }
+    if (isolate_controller) {
+        if (controller_thread.cpu < 0) {
+            cerr << "--isolate-controller needs the controller pinned with --cpus" << endl;
+            return 1;
+        }
+        input_thread.avoid_cpu = controller_thread.cpu;
+        for (Device d : ALL_DEVICES) device_threads[d].avoid_cpu = controller_thread.cpu;
+    }
+    config.controller_thread = controller_thread;
+    config.device_threads = device_threads;
+
+    SpinConfig spin_config = SpinConfig::defaults();
+    spin_config.controller_thread = controller_thread;
+    spin_config.device_threads = device_threads;
+    // same as the original device threads: 0.8-2s, 1-3s, 1.5-4s
+    array<ArrivalSpec, DEVICE_SLOTS> arrivals;
+    arrivals[KEYBOARD] = ArrivalSpec::uniform_ms(800, 2000);
+    arrivals[MOUSE] = ArrivalSpec::uniform_ms(1000, 3000);
+    arrivals[PRINTER] = ArrivalSpec::uniform_ms(1500, 4000);
+    array<ArrivalSpec, DEVICE_SLOTS> &arrival_specs = spin ? spin_config.arrivals : arrivals;
+    array<ServiceSpec, DEVICE_SLOTS> &service_specs = spin ? spin_config.service : config.service;
+    for (auto &m : model_args) {
+        string spec, error;
+        Device dev;
+        if (!split_device_spec(m.second, dev, spec)) {
+            cerr << m.first << " expects D=SPEC with D one of k|m|p" << endl;
+            return 1;
+        }
+        bool ok = m.first == "--arrival" ? ArrivalSpec::parse(spec, arrival_specs[dev], error)
+                                         : ServiceSpec::parse(spec, service_specs[dev], error);
+        if (!ok) {
+            cerr << m.first << " " << m.second << ": " << error << endl;
+            return 1;
         }
     }
-}
 
-void user_input_thread() {
-    string cmd;
-    while (running) {
-        if(!getline(cin, cmd)) break; // e.g., EOF
-        if (cmd.empty()) continue;
-        stringstream ss(cmd);
-        string token;
-        ss >> token;
-        if (token == "mask") {
-            string which; ss >> which;
-            if (which == "k") { masked_keyboard = true; cout << "Keyboard masked." << endl; }
-            else if (which == "m") { masked_mouse = true; cout << "Mouse masked." << endl; }
-            else if (which == "p") { masked_printer = true; cout << "Printer masked." << endl; }
-            else cout << "Unknown device. Use k/m/p." << endl;
-            cv.notify_one();
-        } else if (token == "unmask") {
-            string which; ss >> which;
-            if (which == "k") { masked_keyboard = false; cout << "Keyboard unmasked." << endl; }
-            else if (which == "m") { masked_mouse = false; cout << "Mouse unmasked." << endl; }
-            else if (which == "p") { masked_printer = false; cout << "Printer unmasked." << endl; }
-            else cout << "Unknown device. Use k/m/p." << endl;
-            cv.notify_one();
-        } else if (token == "status") {
-            lock_guard<mutex> lg(mtx);
-            cout << "Status:\n";
-            cout << "  Keyboard: " << (masked_keyboard?"Masked":"Unmasked") << "\n";
-            cout << "  Mouse:    " << (masked_mouse?"Masked":"Unmasked") << "\n";
-            cout << "  Printer:  " << (masked_printer?"Masked":"Unmasked") << "\n";
-            cout << "  Pending interrupts: " << pending.size() << "\n";
-        } else if (token == "exit") {
-            cout << "Exiting..." << endl;
-            running = false;
-            cv.notify_all();
-            break;
-        } else {
-            cout << "Commands: mask k|m|p, unmask k|m|p, status, exit" << endl;
+    Scenario scenario;
+    if (!scenario_path.empty()) {
+        string error;
+        if (!Scenario::load(scenario_path, scenario, error)) {
+            cerr << error << endl;
+            return 1;
+        }
+        for (Device d : ALL_DEVICES) {
+            if (scenario.has_arrival[d]) arrivals[d] = scenario.arrival[d];
+            if (scenario.has_service[d]) config.service[d] = scenario.service[d];
         }
+    } else if (virtual_time) {
+        cerr << "--virtual needs --scenario FILE" << endl;
+        return 1;
+    }
+    if (!virtual_time && (!checkpoint_path.empty() || !resume_path.empty() || !branch_paths.empty())) {
+        cerr << "checkpoints and branches need --scenario FILE --virtual" << endl;
+        return 1;
+    }
+    vector<Branch> branches;
+    for (const string &path : branch_paths) {
+        Branch b;
+        string error;
+        if (!Scenario::load(path, b.scenario, error)) {
+            cerr << error << endl;
+            return 1;
+        }
+        b.name = path;
+        branches.push_back(b);
     }
-}
 
-int main() {
-    // clear log file
-    {
-        lock_guard<mutex> lg(log_mtx);
-        ofstream f(log_filename, ios::trunc);
-        if (f) f << "ISR Log Started: " << chrono::system_clock::to_time_t(chrono::system_clock::now()) << "\n";
+    if (virtual_time) {
+        SimConfig sim_config;
+        for (Device d : ALL_DEVICES) {
+            sim_config.devices[d].arrival = arrivals[d];
+            sim_config.devices[d].service = config.service[d];
+        }
+        sim_config.policy = scenario.has_policy ? scenario.policy : config.policy;
+        sim_config.seed = seed;
+        sim_config.duration_s = scenario.duration_s;
+        Simulation sim(sim_config);
+        if (!sim.set_tpr(config.tpr)) {
+            cerr << "--tpr: level out of range" << endl;
+            return 1;
+        }
+        string error;
+        if (!resume_path.empty() && !load_checkpoint(resume_path, sim, error)) {
+            cerr << "--resume: " << error << endl;
+            return 1;
+        }
+        int64_t resumed_at = sim.now();
+        if (!run_scenario_virtual(scenario, sim, !resume_path.empty(), error)) {
+            cerr << scenario_path << ": " << error << endl;
+            return 1;
+        }
+        if (!checkpoint_path.empty() && !save_checkpoint(sim, checkpoint_path, error)) {
+            cerr << "--save-checkpoint: " << error << endl;
+            return 1;
+        }
+        SimResult result = sim.result();
+        double seconds = result.duration_ns / 1e9;
+        cout << "Scenario " << scenario_path << " in virtual time (" << scenario.duration_s << " s";
+        if (resume_path.empty()) cout << ", seed " << seed;
+        else cout << " from " << resume_path << " at " << resumed_at / 1e9 << " s";
+        cout << "):\n";
+        for (Device d : ALL_DEVICES) {
+            const DeviceStats &s = result.devices[d];
+            cout << "  " << device_name(d) << ": " << s.arrivals << " raised, " << s.dispatched << " dispatched, p99 "
+                 << fixed << setprecision(2) << s.latency.quantile(0.99) / 1e6 << " ms, max " << s.latency.max() / 1e6 << " ms\n";
+        }
+        if (!checkpoint_path.empty()) cout << "Checkpoint at " << seconds << " s saved to " << checkpoint_path << "\n";
+        bool ok = report_expectations(check_expectations(scenario, result.devices, seconds));
+        if (!branches.empty()) {
+            vector<BranchOutcome> outcomes = run_branches(sim, branches);
+            print_branches(outcomes, sim.now());
+            for (const BranchOutcome &o : outcomes) ok = ok && o.error.empty();
+        }
+        return ok ? 0 : 1;
     }
 
-    cout << "Interrupt Controller Simulation (type 'status' to see masks and pending interrupts)" << endl;
-    cout << "Commands: mask k|m|p, unmask k|m|p, status, exit" << endl;
+    if (spin) {
+        spin_config.policy = config.policy;
+        spin_config.workers = (unsigned)spin_workers;
+        for (int w = 0; w < spin_workers && !tpr_levels.empty(); ++w)
+            spin_config.tpr.push_back(tpr_levels[min((size_t)w, tpr_levels.size() - 1)]);
+        spin_config.work = config.work;
+        cout << "Interrupt Controller Simulation, spin mode, running for " << duration_s << " s..." << endl;
+        SpinController sc(spin_config);
+        sc.start();
+        this_thread::sleep_for(chrono::duration<double>(duration_s));
+        sc.stop();
+        SpinReport report = sc.report();
+        print_spin_report(report);
+        print_placement(cout, report.placement);
+        return 0;
+    }
 
-    thread t_keyboard(device_thread, KEYBOARD, 800, 2000); // generate every 0.8-2s
-    thread t_mouse(device_thread, MOUSE, 1000, 3000);     // 1-3s
-    thread t_printer(device_thread, PRINTER, 1500, 4000); // 1.5-4s
+    // sinks are declared before the controller so they outlive its threads
+    ConsoleSink console;
+    IsrLog log(log_options);
+    unique_ptr<TraceSink> trace;
+    if (!trace_path.empty()) trace.reset(new TraceSink(trace_path));
+
+    InterruptController ic(config);
+    if (config.time_source == TimeSource::TSC && ic.time_source() != TimeSource::TSC)
+        cerr << "--tsc: " << ic.time_source_fallback() << "; timestamping with steady_clock" << endl;
+    if (!control_stdin) ic.add_sink(&console);
+    ic.add_sink(&log);
+    if (trace) ic.add_sink(trace.get());
+
+    for (Device d : ALL_DEVICES) ic.add_device(unique_ptr<DeviceModel>(new ArrivalDeviceModel(d, arrivals[d])));
+
+    // declared after the controller so it stops serving before the controller goes away
+    unique_ptr<MetricsServer> metrics;
+    if (!metrics_socket.empty()) {
+        string error;
+        metrics.reset(new MetricsServer(metrics_socket, [&ic]{ return ic.metrics(); }));
+        if (!metrics->start(error)) {
+            cerr << "--metrics-socket: " << error << endl;
+            return 1;
+        }
+    }
 
-    thread t_controller(controller_thread);
-    thread t_user(user_input_thread);
+    // stopped (by its destructor) before the controller, like the metrics server
+    ShmIngress ingress;
+    if (!shm_ingress.empty()) {
+        string error;
+        if (!ingress.start(shm_ingress, 1 << 16, ic, error)) {
+            cerr << "--shm-ingress: " << error << endl;
+            return 1;
+        }
+    }
 
-    // join
-    t_user.join(); // user types exit
-    // ensure running==false
-    running = false;
-    cv.notify_all();
+    if (!scenario_path.empty()) {
+        cout << "Interrupt Controller Simulation, scenario " << scenario_path << " (" << scenario.duration_s << " s)" << endl;
+        if (scenario.has_policy) ic.set_policy(scenario.policy);
+        ic.start();
+        run_scenario_realtime(scenario, ic, [](const ScenarioEvent &e, const string &reply, int64_t late_ns) {
+            cout << "[t=" << fixed << setprecision(3) << e.at_ns / 1e9 << "s, +" << setprecision(0) << late_ns / 1e3
+                 << "us] " << e.command << " -> " << reply << endl;
+        });
+        ic.stop();
+        if (trace) trace->set_controller_track(controller_track(ic, config.controller_thread));
+        cout << "Simulation terminated. Log saved to " << log.path() << endl;
+        return report_expectations(check_expectations(scenario, controller_stats(ic), scenario.duration_s)) ? 0 : 1;
+    }
 
-    t_keyboard.join();
-    t_mouse.join();
-    t_printer.join();
-    t_controller.join();
+    if (!control_stdin) {
+        cout << "Interrupt Controller Simulation (type 'status' to see masks and pending interrupts)" << endl;
+        cout << "Commands: mask k|m|p, unmask k|m|p, status, perf, set-rate, set-policy, tpr, exit" << endl;
+    }
 
-    cout << "Simulation terminated. Log saved to " << log_filename << endl;
+    ic.start();
+    // after start() so the controller and device threads do not inherit the input thread's placement
+    PlacementRecord input = apply_placement("input", input_thread);
+    {
+        CommandServer server([&](const string &line, CommandServer::Source from, bool &exit) {
+            if (from == CommandServer::STDIN && !control_stdin) return console_command(ic, line, input, exit);
+            return execute_command(ic, line, exit);
+        });
+        string error;
+        if (!control_socket.empty() && !server.listen_unix(control_socket, error)) {
+            cerr << "--control-socket: " << error << endl;
+            return 1;
+        }
+        if (!server.watch_stdin(error)) {
+            cerr << error << endl;
+            return 1;
+        }
+        server.run(); // until exit, end of input, or a socket client's exit
+    }
+    ic.stop();
+    if (trace) trace->set_controller_track(controller_track(ic, config.controller_thread));
+
+    vector<PlacementRecord> placement = ic.placement();
+    placement.push_back(input);
+    print_placement(cout, placement);
+    if (config.perf_counters) print_perf(cout, ic.perf_report());
+    cout << flush;
+
+    cout << "Simulation terminated. Log saved to " << log.path() << endl;
+    if (trace) cout << "Trace written to " << trace->path() << endl;
+    if (metrics) metrics->stop();
     return 0;
 }
@@ -0,0 +1,107 @@
+#include "ics/affinity.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+namespace ics {
+
+bool pin_current_thread(int cpu) {
+    if (cpu < 0) return true;
+#ifdef __linux__
+    if (cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+int current_cpu() {
+#ifdef __linux__
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+#ifdef __linux__
+// "0-3,6" style list of the CPUs in set
+static string cpu_list(const cpu_set_t &set) {
+    string out;
+    for (int c = 0; c < CPU_SETSIZE; ++c) {
+        if (!CPU_ISSET(c, &set)) continue;
+        int last = c;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &set)) ++last;
+        if (!out.empty()) out += ',';
+        out += to_string(c);
+        if (last > c) out += '-' + to_string(last);
+        c = last;
+    }
+    return out;
+}
+#endif
+
+static void add_error(PlacementRecord &r, const string &what) {
+    if (!r.errors.empty()) r.errors += "; ";
+    r.errors += what;
+}
+
+PlacementRecord apply_placement(const string &role, const ThreadPlacement &p) {
+    PlacementRecord r;
+    r.role = role;
+    r.requested = p;
+#ifdef __linux__
+    pthread_t self = pthread_self();
+    if (p.cpu >= 0) {
+        if (!pin_current_thread(p.cpu)) add_error(r, "cannot pin to cpu " + to_string(p.cpu));
+    } else if (p.avoid_cpu >= 0 && p.avoid_cpu < CPU_SETSIZE) {
+        cpu_set_t set;
+        if (pthread_getaffinity_np(self, sizeof(set), &set) == 0 && CPU_ISSET(p.avoid_cpu, &set)) {
+            CPU_CLR(p.avoid_cpu, &set);
+            // leaving no CPU at all is refused by the kernel; then the thread shares the core
+            if (CPU_COUNT(&set) == 0 || pthread_setaffinity_np(self, sizeof(set), &set) != 0)
+                add_error(r, "cannot keep off cpu " + to_string(p.avoid_cpu));
+        }
+    }
+    if (p.fifo_priority > 0) {
+        sched_param sp{};
+        sp.sched_priority = p.fifo_priority;
+        int err = pthread_setschedparam(self, SCHED_FIFO, &sp);
+        if (err) add_error(r, "SCHED_FIFO/" + to_string(p.fifo_priority) + " refused (" + strerror(err) + ")");
+    }
+
+    cpu_set_t set;
+    if (pthread_getaffinity_np(self, sizeof(set), &set) == 0) r.allowed_cpus = cpu_list(set);
+    int policy;
+    sched_param sp{};
+    if (pthread_getschedparam(self, &policy, &sp) == 0) {
+        r.scheduling = policy == SCHED_FIFO ? "SCHED_FIFO/" + to_string(sp.sched_priority)
+                     : policy == SCHED_RR ? "SCHED_RR/" + to_string(sp.sched_priority)
+                     : "SCHED_OTHER";
+    }
+#else
+    if (p.cpu >= 0 || p.avoid_cpu >= 0) add_error(r, "CPU affinity not supported");
+    if (p.fifo_priority > 0) add_error(r, "SCHED_FIFO not supported");
+#endif
+    r.cpu = current_cpu();
+    return r;
+}
+
+string format_placement(const PlacementRecord &r) {
+    string s = r.role + ": cpu " + (r.cpu >= 0 ? to_string(r.cpu) : string("?"));
+    if (!r.allowed_cpus.empty()) s += " (allowed " + r.allowed_cpus + ")";
+    if (!r.scheduling.empty()) s += ", " + r.scheduling;
+    if (!r.errors.empty()) s += " [" + r.errors + "]";
+    return s;
+}
+
+} // namespace ics
@@ -0,0 +1,56 @@
+// Thread placement helpers: CPU pinning and real-time scheduling.
+// All return false (or report an error) where the platform does not support them.
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ics {
+
+// Restricts the calling thread to one CPU; cpu < 0 leaves it unpinned
+bool pin_current_thread(int cpu);
+// CPU the calling thread is running on, or -1 if unknown
+int current_cpu();
+
+// Requested placement for one thread
+struct ThreadPlacement {
+    int cpu = -1;               // -1 = not pinned
+    int fifo_priority = 0;      // 1..99 = SCHED_FIFO at this priority, 0 = default scheduling
+    int avoid_cpu = -1;         // unpinned threads stay off this CPU (e.g. an isolated controller core)
+};
+
+// What a thread actually got, read back after applying its request
+struct PlacementRecord {
+    std::string role;           // "controller", "Keyboard", "input", ...
+    ThreadPlacement requested;
+    std::string allowed_cpus;   // affinity mask as a list, e.g. "0-3,6"
+    int cpu = -1;               // CPU observed right after placement
+    std::string scheduling;     // e.g. "SCHED_FIFO/50" or "SCHED_OTHER"
+    std::string errors;         // parts of the request that were refused, empty if none
+};
+
+// Applies p to the calling thread. Failures (no such CPU, no permission for
+// SCHED_FIFO) are recorded rather than fatal, so runs still proceed.
+PlacementRecord apply_placement(const std::string &role, const ThreadPlacement &p);
+// One line, e.g. "controller: cpu 2 (allowed 2), SCHED_FIFO/50"
+std::string format_placement(const PlacementRecord &r);
+
+// Collects records from the threads of one run; safe to add to from any thread
+class PlacementLog {
+public:
+    void add(PlacementRecord r) {
+        std::lock_guard<std::mutex> lg(mtx_);
+        records_.push_back(std::move(r));
+    }
+    std::vector<PlacementRecord> records() const {
+        std::lock_guard<std::mutex> lg(mtx_);
+        return records_;
+    }
+
+private:
+    mutable std::mutex mtx_;
+    std::vector<PlacementRecord> records_;
+};
+
+} // namespace ics
@@ -0,0 +1,203 @@
+#include "ics/arrival.h"
+
+#include <cmath>
+#include <sstream>
+
+#include "ics/spec_params.h"
+
+using namespace std;
+
+namespace ics {
+
+static int64_t to_ns(double v) {
+    return v < 1 ? 1 : (int64_t)llround(v);
+}
+
+ArrivalSpec ArrivalSpec::uniform_ms(int min_ms, int max_ms) {
+    ArrivalSpec s;
+    double mean_s = (min_ms + max_ms) / 2000.0;
+    s.rate_hz = 1 / mean_s;
+    s.jitter = (max_ms - min_ms) / 2000.0 / mean_s;
+    return s;
+}
+
+static bool load_trace(const string &path, ArrivalSpec &spec, string &error) {
+    auto gaps = make_shared<vector<int64_t>>();
+    if (!load_ns_samples(path, *gaps, error)) return false;
+    double total = 0;
+    for (int64_t g : *gaps) total += g;
+    spec.trace = gaps;
+    spec.trace_rate_hz = gaps->size() * 1e9 / total;
+    spec.rate_hz = spec.trace_rate_hz;
+    return true;
+}
+
+bool ArrivalSpec::parse(const string &text, ArrivalSpec &spec, string &error) {
+    double prev_rate = spec.rate_hz;
+    spec = ArrivalSpec();
+    spec.rate_hz = prev_rate;
+    string kind;
+    vector<SpecParam> params;
+    if (!split_spec(text, kind, params, error)) return false;
+    if (kind == "uniform") spec.kind = ArrivalKind::UNIFORM;
+    else if (kind == "poisson") spec.kind = ArrivalKind::POISSON;
+    else if (kind == "onoff" || kind == "mmpp") spec.kind = ArrivalKind::ONOFF;
+    else if (kind == "periodic") spec.kind = ArrivalKind::PERIODIC;
+    else if (kind == "pareto") spec.kind = ArrivalKind::PARETO;
+    else if (kind == "trace") spec.kind = ArrivalKind::TRACE;
+    else {
+        error = "unknown arrival model '" + kind + "'";
+        return false;
+    }
+    if (spec.kind == ArrivalKind::PERIODIC) spec.jitter = 0;
+
+    double min_s = -1, max_s = -1, rate = -1;
+    string file;
+    for (const SpecParam &p : params) {
+        if (p.key == "file") {
+            file = p.value;
+            continue;
+        }
+        if (!p.is_number) {
+            error = "bad value for " + p.key + ": '" + p.value + "'";
+            return false;
+        }
+        if (p.key == "rate") rate = p.number;
+        else if (p.key == "jitter") spec.jitter = p.number;
+        else if (p.key == "min") min_s = p.number;
+        else if (p.key == "max") max_s = p.number;
+        else if (p.key == "on") spec.on_s = p.number;
+        else if (p.key == "off") spec.off_s = p.number;
+        else if (p.key == "alpha") spec.alpha = p.number;
+        else {
+            error = "unknown parameter '" + p.key + "' for " + kind;
+            return false;
+        }
+    }
+
+    if (spec.kind == ArrivalKind::TRACE && !load_trace(file, spec, error)) return false;
+    if (min_s >= 0 || max_s >= 0) {
+        if (min_s < 0 || max_s < min_s || max_s == 0) {
+            error = "uniform needs 0 <= min <= max, max > 0";
+            return false;
+        }
+        spec.rate_hz = 2 / (min_s + max_s);
+        spec.jitter = (max_s - min_s) / (min_s + max_s);
+    }
+    if (rate >= 0) spec.rate_hz = rate;
+
+    if (spec.rate_hz <= 0) error = "rate must be positive";
+    else if (spec.jitter > 1) error = "jitter must be <= 1";
+    else if (spec.kind == ArrivalKind::PARETO && spec.alpha <= 1) error = "pareto alpha must be > 1 for a finite mean";
+    else if (spec.kind == ArrivalKind::ONOFF && (spec.on_s <= 0 || spec.off_s < 0)) error = "onoff needs on > 0, off >= 0";
+    return error.empty();
+}
+
+string ArrivalSpec::describe() const {
+    stringstream ss;
+    switch (kind) {
+        case ArrivalKind::UNIFORM: ss << "uniform:rate=" << rate_hz << ",jitter=" << jitter; break;
+        case ArrivalKind::POISSON: ss << "poisson:rate=" << rate_hz; break;
+        case ArrivalKind::ONOFF: ss << "onoff:rate=" << rate_hz << ",on=" << on_s << ",off=" << off_s; break;
+        case ArrivalKind::PERIODIC: ss << "periodic:rate=" << rate_hz << ",jitter=" << jitter; break;
+        case ArrivalKind::PARETO: ss << "pareto:rate=" << rate_hz << ",alpha=" << alpha; break;
+        case ArrivalKind::TRACE: ss << "trace:rate=" << rate_hz; break;
+    }
+    return ss.str();
+}
+
+ArrivalProcess::ArrivalProcess(const ArrivalSpec &spec, uint64_t seed)
+    : spec_(spec), rng_(seed), mean_gap_ns_(1e9 / spec.rate_hz) {
+    if (spec_.kind == ArrivalKind::ONOFF) phase_left_ns_ = rng_.exponential(spec_.on_s * 1e9);
+    if (spec_.kind == ArrivalKind::TRACE && spec_.trace) trace_pos_ = rng_.next() % spec_.trace->size();
+}
+
+int64_t ArrivalProcess::next_gap_ns() {
+    switch (spec_.kind) {
+        case ArrivalKind::UNIFORM:
+            return to_ns(mean_gap_ns_ * (1 + spec_.jitter * (2 * rng_.uniform() - 1)));
+        case ArrivalKind::POISSON:
+            return to_ns(rng_.exponential(mean_gap_ns_));
+        case ArrivalKind::ONOFF: {
+            // burst rate is scaled so the long-run mean matches rate_hz
+            double burst_gap = mean_gap_ns_ * spec_.on_s / (spec_.on_s + spec_.off_s);
+            double gap = 0;
+            for (;;) {
+                double g = rng_.exponential(burst_gap);
+                if (g <= phase_left_ns_) {
+                    phase_left_ns_ -= g;
+                    return to_ns(gap + g);
+                }
+                // burst ends before the next arrival: skip the rest of it and an OFF period
+                gap += phase_left_ns_ + rng_.exponential(spec_.off_s * 1e9);
+                phase_left_ns_ = rng_.exponential(spec_.on_s * 1e9);
+            }
+        }
+        case ArrivalKind::PERIODIC: {
+            double offset = spec_.jitter * (2 * rng_.uniform() - 1) * mean_gap_ns_ / 2;
+            double gap = mean_gap_ns_ + offset - periodic_last_;
+            periodic_last_ = offset;
+            return to_ns(gap);
+        }
+        case ArrivalKind::PARETO: {
+            double xm = mean_gap_ns_ * (spec_.alpha - 1) / spec_.alpha;
+            return to_ns(xm / pow(rng_.uniform_pos(), 1 / spec_.alpha));
+        }
+        case ArrivalKind::TRACE: {
+            const vector<int64_t> &gaps = *spec_.trace;
+            int64_t g = gaps[trace_pos_];
+            trace_pos_ = (trace_pos_ + 1) % gaps.size();
+            return to_ns(g * spec_.trace_rate_hz / spec_.rate_hz);
+        }
+    }
+    return to_ns(mean_gap_ns_);
+}
+
+void ArrivalSpec::save(BinWriter &w) const {
+    w.u8((uint8_t)kind);
+    w.f64(rate_hz);
+    w.f64(jitter);
+    w.f64(on_s);
+    w.f64(off_s);
+    w.f64(alpha);
+    w.u8(trace ? 1 : 0);
+    if (trace) w.i64s(*trace);
+    w.f64(trace_rate_hz);
+}
+
+bool ArrivalSpec::load(BinReader &r) {
+    uint8_t k = r.u8();
+    if (k > (uint8_t)ArrivalKind::TRACE) r.fail();
+    kind = (ArrivalKind)k;
+    rate_hz = r.f64();
+    jitter = r.f64();
+    on_s = r.f64();
+    off_s = r.f64();
+    alpha = r.f64();
+    trace.reset();
+    if (r.u8()) trace = make_shared<const vector<int64_t>>(r.i64s());
+    trace_rate_hz = r.f64();
+    if (kind == ArrivalKind::TRACE && (!trace || trace->empty())) r.fail();
+    return r.ok();
+}
+
+void ArrivalProcess::save(BinWriter &w) const {
+    spec_.save(w);
+    rng_.save(w);
+    w.f64(mean_gap_ns_);
+    w.f64(phase_left_ns_);
+    w.f64(periodic_last_);
+    w.u64(trace_pos_);
+}
+
+bool ArrivalProcess::load(BinReader &r) {
+    if (!spec_.load(r) || !rng_.load(r)) return false;
+    mean_gap_ns_ = r.f64();
+    phase_left_ns_ = r.f64();
+    periodic_last_ = r.f64();
+    trace_pos_ = r.u64();
+    if (spec_.trace && trace_pos_ >= spec_.trace->size()) r.fail();
+    return r.ok();
+}
+
+} // namespace ics
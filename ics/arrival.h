@@ -0,0 +1,69 @@
+// Arrival processes: when a device raises its next interrupt.
+// rate_hz is always the long-run mean arrival rate, whatever the model, so a
+// sweep over rates means the same thing for every kind. Gaps are in ns.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ics/rng.h"
+
+namespace ics {
+
+enum class ArrivalKind {
+    UNIFORM,    // gaps uniform in [(1 - jitter), (1 + jitter)] / rate
+    POISSON,    // exponential gaps
+    ONOFF,      // two-state MMPP: Poisson bursts during exponential ON periods, silent OFF periods
+    PERIODIC,   // fixed period, each arrival displaced by up to +-jitter/2 periods (no drift)
+    PARETO,     // heavy-tailed gaps with shape alpha > 1
+    TRACE       // recorded gaps replayed in a loop, time-scaled to rate
+};
+
+struct ArrivalSpec {
+    ArrivalKind kind = ArrivalKind::UNIFORM;
+    double rate_hz = 1.0;
+    double jitter = 0.5;            // UNIFORM, PERIODIC
+    double on_s = 0.1, off_s = 0.9; // ONOFF mean period lengths
+    double alpha = 1.5;             // PARETO shape
+    std::shared_ptr<const std::vector<int64_t>> trace; // TRACE gaps, ns
+    double trace_rate_hz = 0;       // native rate of the trace
+
+    // "kind[:key=value,...]", e.g.
+    //   uniform:min=0.8,max=2        (seconds)    poisson:rate=100
+    //   onoff:rate=50,on=0.01,off=0.2              periodic:rate=1000,jitter=0.05
+    //   pareto:rate=10,alpha=1.2                   trace:file=gaps.txt[,rate=R]
+    // Trace files hold one inter-arrival gap in ns per line. Without rate= (or a trace)
+    // the spec keeps its current rate. Returns false and fills error on bad input.
+    static bool parse(const std::string &text, ArrivalSpec &spec, std::string &error);
+    static ArrivalSpec uniform_ms(int min_ms, int max_ms);
+    std::string describe() const;
+
+    // Checkpoint encoding, trace included
+    void save(BinWriter &w) const;
+    bool load(BinReader &r);
+};
+
+class ArrivalProcess {
+public:
+    ArrivalProcess(const ArrivalSpec &spec, uint64_t seed);
+    int64_t next_gap_ns();
+    const ArrivalSpec &spec() const { return spec_; }
+
+    // Full state, so a restored process continues the same sequence of gaps
+    void save(BinWriter &w) const;
+    bool load(BinReader &r);
+
+private:
+    ArrivalSpec spec_;
+    BlockRng rng_;
+    double mean_gap_ns_;
+    // ONOFF: time left in the current ON period. Between calls the process is
+    // always in an ON period; OFF periods are skipped inside next_gap_ns()
+    double phase_left_ns_ = 0;
+    double periodic_last_ = 0;  // PERIODIC: offset of the previous arrival from its nominal slot, ns
+    size_t trace_pos_ = 0;
+};
+
+} // namespace ics
@@ -0,0 +1,97 @@
+// Minimal little-endian binary encoding for checkpoints. Fixed-width fields,
+// no alignment or padding, so files are compact and portable between builds.
+// BinReader never reads past its end: a short or corrupt input just clears ok().
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace ics {
+
+class BinWriter {
+public:
+    void u8(uint8_t v) { buf_.push_back((char)v); }
+    void u32(uint32_t v) { put(v, 4); }
+    void u64(uint64_t v) { put(v, 8); }
+    void i64(int64_t v) { put((uint64_t)v, 8); }
+    void f64(double v) {
+        uint64_t bits;
+        std::memcpy(&bits, &v, 8);
+        put(bits, 8);
+    }
+    void str(const std::string &s) {
+        u64(s.size());
+        buf_ += s;
+    }
+    void i64s(const std::vector<int64_t> &v) {
+        u64(v.size());
+        for (int64_t x : v) i64(x);
+    }
+    const std::string &data() const { return buf_; }
+
+private:
+    void put(uint64_t v, int bytes) {
+        for (int i = 0; i < bytes; ++i) buf_.push_back((char)(v >> (8 * i)));
+    }
+    std::string buf_;
+};
+
+class BinReader {
+public:
+    BinReader(const char *data, size_t size) : p_(data), end_(data + size) {}
+
+    uint8_t u8() { return (uint8_t)get(1); }
+    uint32_t u32() { return (uint32_t)get(4); }
+    uint64_t u64() { return get(8); }
+    int64_t i64() { return (int64_t)get(8); }
+    double f64() {
+        uint64_t bits = get(8);
+        double v;
+        std::memcpy(&v, &bits, 8);
+        return v;
+    }
+    std::string str() {
+        uint64_t n = u64();
+        if (!ok_ || n > (uint64_t)(end_ - p_)) {
+            fail();
+            return std::string();
+        }
+        std::string s(p_, n);
+        p_ += n;
+        return s;
+    }
+    std::vector<int64_t> i64s() {
+        uint64_t n = u64();
+        if (!ok_ || n > (uint64_t)(end_ - p_) / 8) {
+            fail();
+            return std::vector<int64_t>();
+        }
+        std::vector<int64_t> v(n);
+        for (auto &x : v) x = i64();
+        return v;
+    }
+
+    bool ok() const { return ok_; }
+    bool at_end() const { return p_ == end_; }
+    // Marks the input as invalid, e.g. when a decoded value is out of range
+    void fail() { ok_ = false; }
+
+private:
+    uint64_t get(int bytes) {
+        if (!ok_ || end_ - p_ < bytes) {
+            ok_ = false;
+            return 0;
+        }
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; ++i) v |= (uint64_t)(uint8_t)p_[i] << (8 * i);
+        p_ += bytes;
+        return v;
+    }
+    const char *p_;
+    const char *end_;
+    bool ok_ = true;
+};
+
+} // namespace ics
@@ -0,0 +1,89 @@
+#include "ics/checkpoint.h"
+
+#include <fstream>
+#include <iterator>
+
+#include "ics/binio.h"
+
+using namespace std;
+
+namespace ics {
+
+static const char MAGIC[8] = {'I', 'C', 'S', 'C', 'K', 'P', 'T', '1'};
+static const uint32_t VERSION = 4;
+
+static uint64_t fnv1a(const string &data) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+bool save_checkpoint(const Simulation &sim, const string &path, string &error) {
+    BinWriter payload;
+    sim.save(payload);
+    BinWriter w;
+    w.u32(VERSION);
+    w.u64(payload.data().size());
+    string tmp = path + ".tmp"; // written aside and renamed, so a crash never leaves a torn checkpoint
+    {
+        ofstream out(tmp, ios::binary | ios::trunc);
+        out.write(MAGIC, sizeof(MAGIC));
+        out << w.data() << payload.data();
+        BinWriter sum;
+        sum.u64(fnv1a(payload.data()));
+        out << sum.data();
+        if (!out.flush()) {
+            error = tmp + ": write failed";
+            return false;
+        }
+    }
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        error = path + ": cannot replace";
+        return false;
+    }
+    return true;
+}
+
+bool load_checkpoint(const string &path, Simulation &sim, string &error) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        error = path + ": cannot open";
+        return false;
+    }
+    string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    if (data.size() < sizeof(MAGIC) + 4 + 8 + 8 || data.compare(0, sizeof(MAGIC), MAGIC, sizeof(MAGIC)) != 0) {
+        error = path + ": not a checkpoint";
+        return false;
+    }
+    BinReader head(data.data() + sizeof(MAGIC), 12);
+    uint32_t version = head.u32();
+    uint64_t size = head.u64();
+    size_t start = sizeof(MAGIC) + 12;
+    if (version != VERSION) {
+        error = path + ": unsupported checkpoint version " + to_string(version);
+        return false;
+    }
+    if (size != data.size() - start - 8) {
+        error = path + ": truncated checkpoint";
+        return false;
+    }
+    string payload = data.substr(start, size);
+    BinReader tail(data.data() + start + size, 8);
+    if (tail.u64() != fnv1a(payload)) {
+        error = path + ": checksum mismatch";
+        return false;
+    }
+    BinReader r(payload.data(), payload.size());
+    Simulation loaded(sim);
+    if (!loaded.load(r) || !r.at_end()) {
+        error = path + ": corrupt checkpoint";
+        return false;
+    }
+    sim = loaded;
+    return true;
+}
+
+} // namespace ics
@@ -0,0 +1,16 @@
+// Checkpoint files for the virtual-time Simulation.
+// Layout: "ICSCKPT1", format version (u32), payload length (u64), payload
+// (Simulation::save), FNV-1a 64 checksum of the payload. Integers are little-endian.
+#pragma once
+
+#include <string>
+
+#include "ics/simulation.h"
+
+namespace ics {
+
+bool save_checkpoint(const Simulation &sim, const std::string &path, std::string &error);
+// Replaces sim's state; sim is left untouched if the file is missing, truncated or corrupt
+bool load_checkpoint(const std::string &path, Simulation &sim, std::string &error);
+
+} // namespace ics
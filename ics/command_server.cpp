@@ -0,0 +1,228 @@
+#include "ics/command_server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace ics {
+
+// A client that sends a longer line without a newline is disconnected
+static const size_t MAX_LINE = 4096;
+static const int MAX_EVENTS = 32;
+
+CommandServer::CommandServer(Handler handler) : handler_(move(handler)) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+}
+
+CommandServer::~CommandServer() {
+    while (!clients_.empty()) close_client(clients_.begin()->first);
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        unlink(socket_path_.c_str());
+    }
+    if (stdin_flags_ >= 0) fcntl(STDIN_FILENO, F_SETFL, stdin_flags_);
+    close(wake_fd_);
+    close(epoll_fd_);
+}
+
+bool CommandServer::listen_unix(const string &path, string &error) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        error = path + ": socket path too long";
+        return false;
+    }
+    strcpy(addr.sun_path, path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        error = string("socket: ") + strerror(errno);
+        return false;
+    }
+    unlink(path.c_str()); // left behind by an earlier run
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        error = path + ": " + strerror(errno);
+        close(fd);
+        return false;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+    listen_fd_ = fd;
+    socket_path_ = path;
+    return true;
+}
+
+bool CommandServer::watch_stdin(string &error) {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = STDIN_FILENO;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, STDIN_FILENO, &ev) == 0) {
+        stdin_polled_ = true;
+        stdin_flags_ = fcntl(STDIN_FILENO, F_GETFL, 0);
+        if (stdin_flags_ >= 0) fcntl(STDIN_FILENO, F_SETFL, stdin_flags_ | O_NONBLOCK);
+    } else if (errno != EPERM) { // EPERM: a regular file, always readable
+        error = string("stdin: ") + strerror(errno);
+        return false;
+    }
+    stdin_open_ = true;
+    return true;
+}
+
+void CommandServer::stop() {
+    uint64_t one = 1;
+    ssize_t n = write(wake_fd_, &one, sizeof(one));
+    (void)n;
+}
+
+void CommandServer::handle_lines(string &buffer, Source from, string &replies) {
+    size_t start = 0, nl;
+    while (!exit_ && (nl = buffer.find('\n', start)) != string::npos) {
+        string line = buffer.substr(start, nl - start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        start = nl + 1;
+        string reply = handler_(line, from, exit_);
+        if (!reply.empty()) replies += reply + "\n";
+    }
+    buffer.erase(0, start);
+}
+
+void CommandServer::read_stdin() {
+    char buf[4096];
+    string replies;
+    for (;;) {
+        ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+        if (n > 0) {
+            stdin_buf_.append(buf, n);
+            handle_lines(stdin_buf_, STDIN, replies);
+            if (!stdin_polled_ || exit_) break; // files: one chunk per loop turn, so stop() stays prompt
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) break;
+        // EOF (or error): a final unterminated line still counts
+        if (!stdin_buf_.empty()) {
+            stdin_buf_ += '\n';
+            handle_lines(stdin_buf_, STDIN, replies);
+        }
+        stdin_open_ = false;
+        if (stdin_polled_) epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, STDIN_FILENO, nullptr);
+        if (listen_fd_ < 0) exit_ = true;
+        break;
+    }
+    if (!replies.empty()) cout << replies << flush; // through cout so it stays ordered with other console output
+}
+
+void CommandServer::accept_clients() {
+    for (;;) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        clients_[fd];
+    }
+}
+
+void CommandServer::read_client(int fd) {
+    Client &c = clients_[fd];
+    if (c.eof) { // hangup on a half-closed client: nothing more to read
+        flush_client(fd);
+        return;
+    }
+    char buf[16384];
+    for (;;) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            c.in.append(buf, n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        c.eof = n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+        break;
+    }
+    handle_lines(c.in, SOCKET, c.out);
+    if (c.in.size() > MAX_LINE) {
+        close_client(fd);
+        return;
+    }
+    flush_client(fd);
+}
+
+void CommandServer::flush_client(int fd) {
+    Client &c = clients_[fd];
+    while (!c.out.empty()) {
+        ssize_t n = send(fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            c.out.erase(0, n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        close_client(fd);
+        return;
+    }
+    // half-closed clients still get their replies; close once those are written
+    if (c.eof && c.out.empty()) {
+        close_client(fd);
+        return;
+    }
+    // after EOF the read side stays readable forever, so watch only for write space
+    epoll_event ev{};
+    ev.events = c.eof ? EPOLLOUT : EPOLLIN | EPOLLRDHUP;
+    if (!c.out.empty()) ev.events |= EPOLLOUT;
+    ev.data.fd = fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void CommandServer::close_client(int fd) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    clients_.erase(fd);
+}
+
+void CommandServer::run() {
+    epoll_event events[MAX_EVENTS];
+    while (!exit_) {
+        // a stdin file is read directly, one chunk per turn
+        int timeout = stdin_open_ && !stdin_polled_ ? 0 : -1;
+        int n = epoll_wait(epoll_fd_, events, MAX_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) break;
+        for (int i = 0; i < n && !exit_; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd_) {
+                exit_ = true;
+            } else if (fd == listen_fd_) {
+                accept_clients();
+            } else if (fd == STDIN_FILENO && stdin_polled_) {
+                read_stdin();
+            } else if (clients_.count(fd)) {
+                if (events[i].events & EPOLLOUT) flush_client(fd);
+                if (clients_.count(fd) && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+                    read_client(fd);
+            }
+        }
+        if (!exit_ && stdin_open_ && !stdin_polled_) read_stdin();
+    }
+    // best effort: deliver replies (e.g. to the exit command) still queued
+    for (auto it = clients_.begin(); it != clients_.end();) {
+        int fd = (it++)->first;
+        flush_client(fd);
+    }
+}
+
+} // namespace ics
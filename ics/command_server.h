@@ -0,0 +1,65 @@
+// Non-blocking control plane: an epoll event loop that reads newline-separated
+// commands from a Unix domain socket (any number of clients) and/or stdin and
+// writes one reply per command. Everything a client sends in one go is handled
+// in one pass and answered with a single write, so scripts can pipeline
+// thousands of commands per second. Nothing here blocks on a reader, so stop()
+// ends the loop promptly even while stdin is idle.
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace ics {
+
+class CommandServer {
+public:
+    enum Source { STDIN, SOCKET };
+    // Handles one line (without newline); returns the reply (without newline),
+    // or "" for none. Setting exit ends run() once replies are flushed.
+    using Handler = std::function<std::string(const std::string &line, Source from, bool &exit)>;
+
+    explicit CommandServer(Handler handler);
+    ~CommandServer(); // closes clients and removes the socket file
+    CommandServer(const CommandServer &) = delete;
+    CommandServer &operator=(const CommandServer &) = delete;
+
+    // Accept clients on a Unix socket at path (a stale socket file is replaced)
+    bool listen_unix(const std::string &path, std::string &error);
+    // Read commands from stdin; replies go to stdout. EOF on stdin ends run()
+    // unless a socket is also being served.
+    bool watch_stdin(std::string &error);
+
+    // Serves until a command requests exit, stdin ends (see above) or stop()
+    void run();
+    // Callable from any thread, including signal-free shutdown paths
+    void stop();
+
+private:
+    struct Client {
+        std::string in, out;
+        bool eof = false; // peer closed its write side; only the replies in out remain
+    };
+
+    void handle_lines(std::string &buffer, Source from, std::string &replies);
+    void read_stdin();
+    void accept_clients();
+    void read_client(int fd);
+    void flush_client(int fd);
+    void close_client(int fd);
+
+    Handler handler_;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;         // eventfd written by stop()
+    int listen_fd_ = -1;
+    std::string socket_path_;
+    bool stdin_open_ = false;
+    bool stdin_polled_ = false; // regular files cannot be added to epoll; those are read directly
+    int stdin_flags_ = -1;      // restored on destruction, since O_NONBLOCK is shared with the shell
+    std::string stdin_buf_;
+    std::map<int, Client> clients_;
+    bool exit_ = false;
+};
+
+} // namespace ics
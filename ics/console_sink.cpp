@@ -0,0 +1,22 @@
+#include "ics/console_sink.h"
+
+#include <iostream>
+
+using namespace std;
+
+namespace ics {
+
+void ConsoleSink::isr_started(const InterruptEvent &ev, time_point) {
+    cout << device_name(ev.dev) << " Interrupt Triggered → Handling ISR → ";
+    cout << "Started at " << format_local_time(chrono::system_clock::now()) << endl;
+}
+
+void ConsoleSink::isr_finished(const InterruptEvent &ev, time_point, time_point) {
+    cout << device_name(ev.dev) << " ISR Completed at " << format_local_time(chrono::system_clock::now()) << endl;
+}
+
+void ConsoleSink::interrupt_masked(const InterruptEvent &ev) {
+    cout << device_name(ev.dev) << " Interrupt Ignored (Masked)" << endl;
+}
+
+} // namespace ics
@@ -0,0 +1,15 @@
+// Prints ISR progress and masked interrupts to stdout.
+#pragma once
+
+#include "ics/isr_sink.h"
+
+namespace ics {
+
+class ConsoleSink : public IsrSink {
+public:
+    void isr_started(const InterruptEvent &ev, time_point start) override;
+    void isr_finished(const InterruptEvent &ev, time_point start, time_point end) override;
+    void interrupt_masked(const InterruptEvent &ev) override;
+};
+
+} // namespace ics
@@ -0,0 +1,71 @@
+#include "ics/control.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+
+using namespace std;
+
+namespace ics {
+
+bool parse_device_letter(const string &s, Device &dev) {
+    string l;
+    for (char c : s) l += (char)tolower((unsigned char)c);
+    if (l == "k" || l == "keyboard") dev = KEYBOARD;
+    else if (l == "m" || l == "mouse") dev = MOUSE;
+    else if (l == "p" || l == "printer") dev = PRINTER;
+    else return false;
+    return true;
+}
+
+static string lower(string s) {
+    for (char &c : s) c = (char)tolower((unsigned char)c);
+    return s;
+}
+
+string execute_command(InterruptController &ic, const string &line, bool &exit_requested) {
+    stringstream ss(line);
+    string cmd, arg;
+    if (!(ss >> cmd) || cmd[0] == '#') return "";
+    Device dev;
+    if (cmd == "mask" || cmd == "unmask") {
+        if (!(ss >> arg) || !parse_device_letter(arg, dev)) return "err " + cmd + " expects k|m|p";
+        ic.set_mask(dev, cmd == "mask");
+        return "ok " + device_name(dev) + " " + cmd + "ed";
+    }
+    if (cmd == "status") {
+        ControllerStatus st = ic.status();
+        string r = "ok";
+        for (Device d : ALL_DEVICES) r += " " + lower(device_name(d)) + "=" + (st.masked[d] ? "masked" : "unmasked");
+        return r + " tpr=" + to_string(st.tpr) + " pending=" + to_string(st.pending) +
+               " dispatched=" + to_string(st.dispatched) + " policy=" + policy_name(ic.policy());
+    }
+    if (cmd == "set-rate") {
+        string hz_text;
+        if (!(ss >> arg >> hz_text) || !parse_device_letter(arg, dev)) return "err set-rate expects k|m|p HZ";
+        char *end = nullptr;
+        double hz = strtod(hz_text.c_str(), &end);
+        if (*end || !(hz > 0)) return "err set-rate: rate must be a positive number";
+        if (!ic.set_rate(dev, hz)) return "err set-rate: " + device_name(dev) + " has no rate-driven model";
+        return "ok " + device_name(dev) + " rate=" + hz_text;
+    }
+    if (cmd == "set-policy") {
+        SchedulingPolicy p;
+        if (!(ss >> arg) || !parse_policy(arg, p)) return "err set-policy expects priority|fifo|rr";
+        ic.set_policy(p);
+        return string("ok policy=") + policy_name(p);
+    }
+    if (cmd == "tpr") {
+        int level;
+        if (!(ss >> arg) || !parse_tpr(arg, level) || !ic.set_tpr(level))
+            return "err tpr expects a level 0-" + to_string(MAX_TPR);
+        return "ok tpr=" + to_string(level);
+    }
+    if (cmd == "exit") {
+        exit_requested = true;
+        return "ok bye";
+    }
+    return "err unknown command '" + cmd + "' (mask, unmask, status, set-rate, set-policy, tpr, exit)";
+}
+
+} // namespace ics
@@ -0,0 +1,26 @@
+// Line-oriented control protocol shared by the command server and scripts.
+// One command per line, one reply line per command, starting with "ok" or "err":
+//   mask k|m|p             -> ok Keyboard masked
+//   unmask k|m|p           -> ok Keyboard unmasked
+//   status                 -> ok keyboard=unmasked mouse=masked printer=unmasked tpr=0 pending=3 dispatched=120 policy=priority
+//   set-rate k|m|p HZ      -> ok Keyboard rate=250
+//   set-policy priority|fifo|rr -> ok policy=fifo
+//   tpr LEVEL              -> ok tpr=2 (holds back classes <= 2: Printer and Mouse)
+//   exit                   -> ok bye (and exit_requested is set)
+// Blank lines and lines starting with '#' get no reply.
+#pragma once
+
+#include <string>
+
+#include "ics/interrupt_controller.h"
+
+namespace ics {
+
+// "k", "m", "p" (or a full device name, any case)
+bool parse_device_letter(const std::string &s, Device &dev);
+
+// Runs one command line against ic. Returns the reply without a trailing
+// newline, or an empty string for lines that need none.
+std::string execute_command(InterruptController &ic, const std::string &line, bool &exit_requested);
+
+} // namespace ics
@@ -0,0 +1,214 @@
+// C++20 coroutine building blocks for simulating very many devices on a few
+// threads: device behaviour and multi-step ISRs are coroutines that co_await
+// delays and I/O completions, and an Executor resumes them in time order.
+// A suspended coroutine costs only its frame (typically around a hundred bytes)
+// instead of a thread and its stack. Header-only and C++20; the rest of the
+// library stays C++17 (see the interrupt_coro target).
+#pragma once
+
+#if __cplusplus < 202002L
+#error "ics/coro.h needs C++20"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ics {
+
+// Live coroutine frames across all executors (allocated through Task's promise)
+struct FrameStats {
+    static inline std::atomic<size_t> frames{0};
+    static inline std::atomic<size_t> bytes{0};
+};
+
+// A coroutine returning nothing. Lazily started: either co_await it from another
+// coroutine (the awaiter resumes when it finishes, e.g. an ISR awaited by the
+// controller) or hand it to Executor::spawn() to run on its own.
+class Task {
+public:
+    struct promise_type {
+        std::coroutine_handle<> continuation; // resumed when this task finishes
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            // stays suspended at the end; its owner (awaiting Task or the executor) frees the frame
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                std::coroutine_handle<> next = h.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+
+        static void *operator new(size_t n) {
+            FrameStats::frames.fetch_add(1, std::memory_order_relaxed);
+            FrameStats::bytes.fetch_add(n, std::memory_order_relaxed);
+            return ::operator new(n);
+        }
+        static void operator delete(void *p, size_t n) {
+            FrameStats::frames.fetch_sub(1, std::memory_order_relaxed);
+            FrameStats::bytes.fetch_sub(n, std::memory_order_relaxed);
+            ::operator delete(p);
+        }
+    };
+
+    Task(Task &&o) noexcept : h_(std::exchange(o.h_, {})) {}
+    Task &operator=(Task &&o) noexcept {
+        if (this != &o) {
+            if (h_) h_.destroy();
+            h_ = std::exchange(o.h_, {});
+        }
+        return *this;
+    }
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+    ~Task() {
+        if (h_) h_.destroy();
+    }
+
+    // Awaiting runs the task to completion, then resumes the awaiter (symmetric transfer)
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        h_.promise().continuation = awaiter;
+        return h_;
+    }
+    void await_resume() noexcept {}
+
+    // Hands the frame over, e.g. to an executor
+    std::coroutine_handle<promise_type> release() { return std::exchange(h_, {}); }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> h) : h_(h) {}
+    std::coroutine_handle<promise_type> h_;
+};
+
+class Executor;
+
+// One-shot completion (an I/O finishing, work arriving): co_await suspends until
+// set(); a single waiter at a time. reset() re-arms it.
+class Completion {
+public:
+    explicit Completion(Executor &ex) : ex_(ex) {}
+    bool await_ready() const noexcept { return set_; }
+    void await_suspend(std::coroutine_handle<> h) noexcept { waiter_ = h; }
+    void await_resume() noexcept {}
+
+    void set();
+    void reset() { set_ = false; }
+    bool is_set() const { return set_; }
+
+private:
+    Executor &ex_;
+    bool set_ = false;
+    std::coroutine_handle<> waiter_;
+};
+
+// Single-threaded scheduler over a timer heap. In VIRTUAL time the clock jumps to
+// the next deadline; in REAL time it sleeps until then, so late resumptions show
+// up as latency. For several cores, run one Executor per thread, each with its
+// own share of the coroutines; an Executor is never touched by two threads.
+class Executor {
+public:
+    enum class Clock { VIRTUAL, REAL };
+
+    explicit Executor(Clock clock = Clock::VIRTUAL) : clock_(clock), start_(std::chrono::steady_clock::now()) {}
+    // Frees every spawned coroutine, finished or still suspended
+    ~Executor() {
+        for (auto h : roots_) h.destroy();
+    }
+    Executor(const Executor &) = delete;
+    Executor &operator=(const Executor &) = delete;
+
+    // Takes ownership of t and starts it on the next run_until()
+    void spawn(Task t) {
+        auto h = t.release();
+        roots_.push_back(h);
+        schedule(now_, h, nullptr);
+    }
+
+    // Nanoseconds since construction (virtual or elapsed)
+    int64_t now() const { return now_; }
+
+    struct DelayAwaiter {
+        Executor &ex;
+        int64_t ns;
+        bool await_ready() const noexcept { return ns <= 0; }
+        void await_suspend(std::coroutine_handle<> h) { ex.schedule(ex.now_ + ns, h, nullptr); }
+        void await_resume() noexcept {}
+    };
+    // co_await ex.delay(ns): resume ns from now
+    DelayAwaiter delay(int64_t ns) { return {*this, ns}; }
+
+    // Sets c ns from now, e.g. a simulated transfer finishing
+    void complete_after(Completion &c, int64_t ns) { schedule(now_ + ns, nullptr, &c); }
+    // Resumes h at the current time, after whatever is already due
+    void post(std::coroutine_handle<> h) { schedule(now_, h, nullptr); }
+
+    // Resumes everything due up to t_ns, in deadline order (ties in scheduling order)
+    void run_until(int64_t t_ns) {
+        while (!timers_.empty() && timers_.top().at <= t_ns) {
+            Timer t = timers_.top();
+            timers_.pop();
+            if (clock_ == Clock::REAL) {
+                std::this_thread::sleep_until(start_ + std::chrono::nanoseconds(t.at));
+                now_ = elapsed_ns();
+            } else if (t.at > now_) {
+                now_ = t.at;
+            }
+            ++resumed_;
+            if (t.completion) t.completion->set();
+            else t.handle.resume();
+        }
+        if (clock_ == Clock::REAL) {
+            std::this_thread::sleep_until(start_ + std::chrono::nanoseconds(t_ns));
+            now_ = elapsed_ns();
+        } else if (t_ns > now_) {
+            now_ = t_ns;
+        }
+    }
+
+    uint64_t resumed() const { return resumed_; }
+    size_t spawned() const { return roots_.size(); }
+
+private:
+    struct Timer {
+        int64_t at;
+        uint64_t order;
+        std::coroutine_handle<> handle;
+        Completion *completion;
+        bool operator>(const Timer &o) const { return at != o.at ? at > o.at : order > o.order; }
+    };
+
+    void schedule(int64_t at, std::coroutine_handle<> h, Completion *c) { timers_.push({at, next_order_++, h, c}); }
+    int64_t elapsed_ns() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    Clock clock_;
+    std::chrono::steady_clock::time_point start_;
+    int64_t now_ = 0;
+    uint64_t next_order_ = 0;
+    uint64_t resumed_ = 0;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::vector<std::coroutine_handle<>> roots_;
+};
+
+inline void Completion::set() {
+    set_ = true;
+    if (waiter_) ex_.post(std::exchange(waiter_, {}));
+}
+
+} // namespace ics
@@ -0,0 +1,79 @@
+#include "ics/cpu_work.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "ics/rng.h"
+
+using namespace std;
+
+namespace ics {
+
+static const size_t STRIDE = 64 / sizeof(uint32_t); // one entry per cache line
+
+const char *isr_work_name(IsrWork w) {
+    switch (w) {
+        case IsrWork::SLEEP: return "sleep";
+        case IsrWork::COMPUTE: return "compute";
+        case IsrWork::MEMORY: return "memory";
+    }
+    return "unknown";
+}
+
+bool parse_isr_work(const char *s, IsrWork &w) {
+    if (!strcmp(s, "sleep")) w = IsrWork::SLEEP;
+    else if (!strcmp(s, "compute")) w = IsrWork::COMPUTE;
+    else if (!strcmp(s, "memory")) w = IsrWork::MEMORY;
+    else return false;
+    return true;
+}
+
+CpuWorkKernel::CpuWorkKernel(IsrWork kind, size_t memory_bytes) : kind_(kind) {
+    if (kind_ != IsrWork::MEMORY) return;
+    // one random cycle through all cache lines (Sattolo's algorithm)
+    size_t lines = max<size_t>(memory_bytes / 64, 2);
+    vector<uint32_t> order(lines);
+    for (size_t i = 0; i < lines; ++i) order[i] = (uint32_t)i;
+    BlockRng rng(12345);
+    for (size_t i = lines - 1; i > 0; --i) swap(order[i], order[rng.next() % i]);
+    next_.assign(lines * STRIDE, 0);
+    for (size_t i = 0; i < lines; ++i) next_[order[i] * STRIDE] = order[(i + 1) % lines];
+}
+
+uint64_t CpuWorkKernel::steps(uint64_t n) {
+    if (kind_ == IsrWork::MEMORY) {
+        uint32_t c = cursor_;
+        for (uint64_t i = 0; i < n; ++i) {
+            ++next_[c * STRIDE + 1];        // write as well, so lines become dirty
+            c = next_[c * STRIDE];
+        }
+        cursor_ = c;
+        return c;
+    }
+    uint64_t h = hash_;
+    for (uint64_t i = 0; i < n; ++i) h = (h ^ (h >> 29)) * 0xbf58476d1ce4e5b9ull + i;
+    hash_ = h;
+    return h;
+}
+
+void CpuWorkKernel::calibrate() {
+    if (kind_ == IsrWork::SLEEP) return;
+    steps(1u << 16); // warm up caches and frequency
+    double best = 0;
+    uint64_t n = 1u << 20;
+    for (int rep = 0; rep < 5; ++rep) {
+        auto t0 = chrono::steady_clock::now();
+        steps(n);
+        double ns = (double)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+        if (ns > 0) best = max(best, n / ns);
+    }
+    if (best > 0) steps_per_ns_ = best;
+}
+
+void CpuWorkKernel::run(int64_t ns) {
+    if (ns <= 0) return;
+    steps((uint64_t)(ns * steps_per_ns_));
+}
+
+} // namespace ics
@@ -0,0 +1,40 @@
+// Calibrated CPU work for ISRs that should burn real cycles instead of sleeping,
+// so cache and core contention show up in the measurements.
+//   COMPUTE - a dependent integer hash chain: keeps one core busy, touches no memory
+//   MEMORY  - a dependent pointer chase over a buffer larger than typical L2 caches,
+//             one cache line per step, defeating the prefetcher
+// calibrate() measures steps per ns on an idle core; run() then performs the
+// step count for the requested duration, so it takes longer under contention.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ics {
+
+enum class IsrWork { SLEEP, COMPUTE, MEMORY };
+
+const char *isr_work_name(IsrWork w);
+bool parse_isr_work(const char *s, IsrWork &w);
+
+class CpuWorkKernel {
+public:
+    explicit CpuWorkKernel(IsrWork kind, size_t memory_bytes = 32u << 20);
+
+    void calibrate();
+    void run(int64_t ns);
+    IsrWork kind() const { return kind_; }
+    double steps_per_ns() const { return steps_per_ns_; }
+
+private:
+    uint64_t steps(uint64_t n);
+
+    IsrWork kind_;
+    std::vector<uint32_t> next_;    // MEMORY: next_[line * STRIDE] = next line index
+    uint32_t cursor_ = 0;
+    uint64_t hash_ = 0x9e3779b97f4a7c15ull;
+    double steps_per_ns_ = 1;
+};
+
+} // namespace ics
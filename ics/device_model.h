@@ -0,0 +1,53 @@
+// Device models decide when a device raises its next interrupt.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <random>
+
+#include "ics/arrival.h"
+#include "ics/types.h"
+
+namespace ics {
+
+class DeviceModel {
+public:
+    virtual ~DeviceModel() = default;
+    virtual Device device() const = 0;
+    // Time to wait before raising the next interrupt
+    virtual std::chrono::nanoseconds next_interval() = 0;
+    // Changes the mean rate from the next interval on; may be called from any thread.
+    // Returns false if the model has no notion of rate.
+    virtual bool set_rate(double hz) { (void)hz; return false; }
+};
+
+// Gaps drawn from an arrival process (uniform, Poisson, on/off, periodic, Pareto, trace)
+class ArrivalDeviceModel : public DeviceModel {
+public:
+    ArrivalDeviceModel(Device dev, const ArrivalSpec &spec, uint64_t seed = std::random_device{}())
+        : dev_(dev), seed_(seed), process_(spec, seed) {}
+    Device device() const override { return dev_; }
+    std::chrono::nanoseconds next_interval() override {
+        double hz = new_rate_.exchange(0);
+        if (hz > 0) {
+            // restart the process at the new rate; same kind and shape, fresh stream
+            ArrivalSpec spec = process_.spec();
+            spec.rate_hz = hz;
+            process_ = ArrivalProcess(spec, splitmix64(++seed_));
+        }
+        return std::chrono::nanoseconds(process_.next_gap_ns());
+    }
+    bool set_rate(double hz) override {
+        if (!(hz > 0)) return false;
+        new_rate_ = hz;
+        return true;
+    }
+
+private:
+    Device dev_;
+    uint64_t seed_;
+    ArrivalProcess process_;             // device thread only
+    std::atomic<double> new_rate_{0};    // pending set_rate(), 0 = none
+};
+
+} // namespace ics
@@ -0,0 +1,90 @@
+#include "ics/histogram.h"
+
+#include <cmath>
+
+namespace ics {
+
+static int msb(uint64_t v) {
+    int n = 63;
+    while (!(v >> n)) --n;
+    return n;
+}
+
+int LatencyHistogram::bucket_of(uint64_t v) {
+    if (v < (uint64_t)SUB) return (int)v;
+    int shift = msb(v) - SUB_BITS; // v >> shift lies in [SUB, 2*SUB)
+    return (shift + 1) * SUB + (int)(v >> shift) - SUB;
+}
+
+uint64_t LatencyHistogram::bucket_low(int idx) {
+    if (idx < SUB) return (uint64_t)idx;
+    int shift = idx / SUB - 1;
+    return (uint64_t)(idx % SUB + SUB) << shift;
+}
+
+void LatencyHistogram::record(int64_t v) {
+    if (v < 0) v = 0;
+    ++counts_[bucket_of((uint64_t)v)];
+    ++count_;
+    sum_ += (double)v;
+    if (v < min_) min_ = v;
+    if (v > max_) max_ = v;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+    for (int i = 0; i < BUCKETS; ++i) counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    if (other.min_ < min_) min_ = other.min_;
+    if (other.max_ > max_) max_ = other.max_;
+}
+
+int64_t LatencyHistogram::quantile(double q) const {
+    if (!count_) return 0;
+    uint64_t rank = (uint64_t)std::ceil(q * (double)count_);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            uint64_t lo = bucket_low(i), hi = i + 1 < BUCKETS ? bucket_low(i + 1) : lo;
+            int64_t mid = (int64_t)(lo + (hi - lo) / 2);
+            return mid < min_ ? min_ : mid > max_ ? max_ : mid;
+        }
+    }
+    return max_;
+}
+
+void LatencyHistogram::save(BinWriter &w) const {
+    uint32_t used = 0;
+    for (uint64_t c : counts_) used += c != 0;
+    w.u32(used);
+    for (int i = 0; i < BUCKETS; ++i)
+        if (counts_[i]) {
+            w.u32((uint32_t)i);
+            w.u64(counts_[i]);
+        }
+    w.u64(count_);
+    w.f64(sum_);
+    w.i64(min_);
+    w.i64(max_);
+}
+
+bool LatencyHistogram::load(BinReader &r) {
+    clear();
+    uint32_t used = r.u32();
+    if (used > (uint32_t)BUCKETS) r.fail();
+    for (uint32_t i = 0; i < used && r.ok(); ++i) {
+        uint32_t idx = r.u32();
+        uint64_t c = r.u64();
+        if (idx >= (uint32_t)BUCKETS) r.fail();
+        else counts_[idx] = c;
+    }
+    count_ = r.u64();
+    sum_ = r.f64();
+    min_ = r.i64();
+    max_ = r.i64();
+    return r.ok();
+}
+
+} // namespace ics
@@ -0,0 +1,47 @@
+// Log-linear latency histogram (HDR-style): 32 linear sub-buckets per power of two,
+// so any recorded value is reported within ~3%. Fixed size, cheap to record and
+// to merge, which lets replications be aggregated exactly.
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "ics/binio.h"
+
+namespace ics {
+
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 5;
+    static const int SUB = 1 << SUB_BITS;
+    static const int BUCKETS = (64 - SUB_BITS) * SUB;
+
+    void record(int64_t v);
+    void merge(const LatencyHistogram &other);
+    void clear() { *this = LatencyHistogram(); }
+
+    uint64_t count() const { return count_; }
+    int64_t min() const { return count_ ? min_ : 0; }
+    int64_t max() const { return max_; }
+    double mean() const { return count_ ? sum_ / count_ : 0.0; }
+    // q in [0, 1]; returns the midpoint of the bucket holding that quantile, clamped to [min, max]
+    int64_t quantile(double q) const;
+
+    const std::array<uint64_t, BUCKETS> &buckets() const { return counts_; }
+
+    static int bucket_of(uint64_t v);
+    static uint64_t bucket_low(int idx);
+
+    // Sparse checkpoint encoding: only non-empty buckets are written
+    void save(BinWriter &w) const;
+    bool load(BinReader &r);
+
+private:
+    std::array<uint64_t, BUCKETS> counts_{};
+    uint64_t count_ = 0;
+    double sum_ = 0;
+    int64_t min_ = INT64_MAX;
+    int64_t max_ = 0;
+};
+
+} // namespace ics
@@ -0,0 +1,344 @@
+#include "ics/interrupt_controller.h"
+
+#include <climits>
+#include <string>
+#include <random>
+
+using namespace std;
+
+namespace ics {
+
+// Latency quantiles are recomputed at most this often; counters are published on every change
+static const chrono::milliseconds QUANTILE_REFRESH(10);
+
+int choose_device(const bool *has, const long long *age, SchedulingPolicy policy, Device last_served) {
+    switch (policy) {
+        case SchedulingPolicy::PRIORITY:
+            // priority: KEYBOARD (3) > MOUSE (2) > PRINTER (1)
+            for (Device d : ALL_DEVICES) if (has[d]) return d;
+            return 0;
+        case SchedulingPolicy::FIFO: {
+            int best = 0;
+            for (Device d : ALL_DEVICES)
+                if (has[d] && (!best || age[d] < age[best])) best = d;
+            return best;
+        }
+        case SchedulingPolicy::ROUND_ROBIN: {
+            Device d = last_served;
+            for (int k = 0; k < DEVICE_SLOTS - 1; ++k) {
+                d = next_in_rotation(d);
+                if (has[d]) return d;
+            }
+            return 0;
+        }
+    }
+    return 0;
+}
+
+int select_next(const vector<InterruptEvent> &events, const MaskRegister &masks,
+                SchedulingPolicy policy, Device last_served, int tpr) {
+    // oldest unmasked event per device
+    int oldest[DEVICE_SLOTS] = {-1, -1, -1, -1};
+    bool has[DEVICE_SLOTS] = {};
+    long long seq[DEVICE_SLOTS] = {LLONG_MAX, LLONG_MAX, LLONG_MAX, LLONG_MAX};
+    bool masked[DEVICE_SLOTS];
+    for (int d = 0; d < DEVICE_SLOTS; ++d) masked[d] = effective_class((Device)d, masks[d]) <= tpr;
+    for (int i = 0; i < (int)events.size(); ++i) {
+        Device d = events[i].dev;
+        if (masked[d]) continue;
+        if (events[i].seq < seq[d]) {
+            oldest[d] = i;
+            seq[d] = events[i].seq;
+            has[d] = true;
+        }
+    }
+    long long age[DEVICE_SLOTS] = {};
+    for (Device d : ALL_DEVICES)
+        if (has[d]) age[d] = events[oldest[d]].timestamp.time_since_epoch().count();
+    int d = choose_device(has, age, policy, last_served);
+    return d ? oldest[d] : -1;
+}
+
+int select_next(const PendingQueue &pending, const MaskRegister &masks, SchedulingPolicy policy, Device last_served,
+                int tpr) {
+    bool masked[DEVICE_SLOTS];
+    for (int d = 0; d < DEVICE_SLOTS; ++d) masked[d] = effective_class((Device)d, masks[d]) <= tpr;
+    long long seq[DEVICE_SLOTS];
+    oldest_per_device(pending.devs(), pending.seqs(), pending.size(), masked, seq);
+    bool has[DEVICE_SLOTS];
+    for (int d = 0; d < DEVICE_SLOTS; ++d) has[d] = seq[d] != LLONG_MAX;
+    int index[DEVICE_SLOTS] = {-1, -1, -1, -1};
+    long long age[DEVICE_SLOTS] = {};
+    if (policy == SchedulingPolicy::FIFO) {
+        // only FIFO compares across devices, and that needs each candidate's timestamp
+        for (Device d : ALL_DEVICES) {
+            if (!has[d]) continue;
+            index[d] = find_seq(pending.seqs(), pending.size(), seq[d]);
+            age[d] = pending.timestamp(index[d]).time_since_epoch().count();
+        }
+    }
+    int d = choose_device(has, age, policy, last_served);
+    if (!d) return -1;
+    return index[d] >= 0 ? index[d] : find_seq(pending.seqs(), pending.size(), seq[d]);
+}
+
+InterruptController::InterruptController(ControllerConfig config)
+    : config_(config), tpr_(config.tpr), policy_(config.policy), clock_(config.time_source) {}
+
+InterruptController::~InterruptController() {
+    stop();
+}
+
+void InterruptController::add_sink(IsrSink *sink) {
+    sinks_.push_back(sink);
+}
+
+void InterruptController::add_device(unique_ptr<DeviceModel> model) {
+    devices_.push_back(move(model));
+    if (running_) device_threads_.emplace_back(&InterruptController::device_loop, this, devices_.back().get());
+}
+
+void InterruptController::start() {
+    if (running_) return;
+    random_device rd;
+    services_.clear();
+    for (int d = 0; d < DEVICE_SLOTS; ++d) services_.emplace_back(config_.service[d], ((uint64_t)rd() << 32) | rd());
+    if (config_.work != IsrWork::SLEEP && !kernel_) {
+        kernel_.reset(new CpuWorkKernel(config_.work));
+        kernel_->calibrate();
+    }
+    running_ = true;
+    controller_ = thread(&InterruptController::controller_loop, this);
+    for (auto &d : devices_) device_threads_.emplace_back(&InterruptController::device_loop, this, d.get());
+}
+
+void InterruptController::stop() {
+    {
+        // running_ changes under both mutexes so no waiter can miss the wakeup
+        lock_guard<mutex> lg(mtx_);
+        lock_guard<mutex> sg(stop_mtx_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    stop_cv_.notify_all();
+    for (auto &t : device_threads_) t.join();
+    device_threads_.clear();
+    if (controller_.joinable()) controller_.join();
+}
+
+void InterruptController::raise(Device dev) {
+    auto now = clock_.now();
+    {
+        lock_guard<mutex> lg(mtx_);
+        InterruptEvent ev{dev, next_seq(dev), now};
+        pending_.push_back(ev);
+        newest_[dev] = ev.seq;
+        ++metrics_.devices[dev].arrivals;
+        ++metrics_.devices[dev].queue_depth;
+        ++metrics_.queue_depth;
+        publish_locked();
+    }
+    cv_.notify_one();
+}
+
+void InterruptController::raise_batch(const InterruptEvent *events, size_t n) {
+    {
+        lock_guard<mutex> lg(mtx_);
+        for (size_t i = 0; i < n; ++i) {
+            pending_.push_back({events[i].dev, next_seq(events[i].dev), events[i].timestamp});
+            newest_[events[i].dev] = pending_[pending_.size() - 1].seq;
+            ++metrics_.devices[events[i].dev].arrivals;
+            ++metrics_.devices[events[i].dev].queue_depth;
+        }
+        metrics_.queue_depth += n;
+        publish_locked();
+    }
+    cv_.notify_one();
+}
+
+void InterruptController::set_mask(Device dev, bool masked) {
+    masks_[dev] = masked;
+    {
+        lock_guard<mutex> lg(mtx_);
+        publish_locked();
+    }
+    for (IsrSink *s : sinks_) s->mask_changed(dev, masked);
+    cv_.notify_one();
+}
+
+bool InterruptController::set_tpr(int level) {
+    if (level < 0 || level > MAX_TPR) return false;
+    tpr_ = level;
+    {
+        lock_guard<mutex> lg(mtx_);
+        publish_locked();
+    }
+    cv_.notify_one();
+    return true;
+}
+
+bool InterruptController::set_rate(Device dev, double hz) {
+    bool any = false;
+    for (auto &m : devices_)
+        if (m->device() == dev && m->set_rate(hz)) any = true;
+    if (!any) return false;
+    {
+        lock_guard<mutex> sg(stop_mtx_);
+        reschedule_[dev] = true;
+    }
+    stop_cv_.notify_all();
+    return true;
+}
+
+ControllerStatus InterruptController::status() const {
+    ControllerStatus st;
+    for (Device d : ALL_DEVICES) st.masked[d] = masks_[d];
+    st.tpr = tpr_;
+    st.cpu = controller_cpu_;
+    st.dispatched = dispatched_;
+    st.pending = published_.load().queue_depth;
+    return st;
+}
+
+LatencyHistogram InterruptController::latency(Device dev) const {
+    lock_guard<mutex> lg(mtx_);
+    return latency_[dev];
+}
+
+void InterruptController::publish_locked() {
+    ++metrics_.version;
+    metrics_.dispatched = dispatched_;
+    for (Device d : ALL_DEVICES) metrics_.devices[d].mask = masks_[d];
+    metrics_.tpr = tpr_;
+    published_.store(metrics_);
+}
+
+void InterruptController::report_blocked_locked(int tpr) {
+    bool any = false;
+    for (Device d : ALL_DEVICES) {
+        // a masked device is reported as masked whatever the TPR; an unmasked one
+        // below the TPR is only deferred. One watermark serves both, so an interrupt
+        // counts once, under whichever held it back first
+        bool masked = masks_[d];
+        if (!masked && priority_class(d) > tpr) continue;
+        if (newest_[d] <= reported_[d]) continue;
+        for (size_t i = 0; i < pending_.size(); ++i) {
+            InterruptEvent ev = pending_[i];
+            if (ev.dev != d || ev.seq <= reported_[d]) continue;
+            if (!masked) {
+                ++metrics_.devices[d].deferred;
+                continue;
+            }
+            ++metrics_.devices[d].masked;
+            for (IsrSink *s : sinks_) s->interrupt_masked(ev);
+        }
+        reported_[d] = newest_[d];
+        any = true;
+    }
+    if (any) publish_locked();
+}
+
+void InterruptController::record_dispatch_locked(const InterruptEvent &ev, chrono::steady_clock::time_point start) {
+    DeviceMetrics &m = metrics_.devices[ev.dev];
+    int64_t wait_ns = chrono::duration_cast<chrono::nanoseconds>(start - ev.timestamp).count();
+    latency_[ev.dev].record(wait_ns);
+    ++m.dispatched;
+    --m.queue_depth;
+    --metrics_.queue_depth;
+    ++m.latency_count;
+    m.latency_sum_ns += wait_ns;
+    if (wait_ns > m.latency_max_ns) m.latency_max_ns = wait_ns;
+    if (start - quantiles_at_ >= QUANTILE_REFRESH) {
+        quantiles_at_ = start;
+        for (Device d : ALL_DEVICES)
+            for (int q = 0; q < METRIC_QUANTILE_COUNT; ++q)
+                metrics_.devices[d].latency_ns[q] = latency_[d].quantile(METRIC_QUANTILES[q]);
+    }
+    publish_locked();
+}
+
+PerfReport InterruptController::perf_report() const {
+    lock_guard<mutex> lg(perf_mtx_);
+    return perf_;
+}
+
+// Device thread: generate interrupts at the intervals the model asks for
+void InterruptController::device_loop(DeviceModel *model) {
+    placement_.add(apply_placement(device_name(model->device()), config_.device_threads[model->device()]));
+    Device dev = model->device();
+    while (running_) {
+        auto wait = model->next_interval();
+        {
+            unique_lock<mutex> ul(stop_mtx_);
+            if (stop_cv_.wait_for(ul, wait, [this, dev]{ return !running_ || reschedule_[dev]; })) {
+                if (!running_) break;
+                reschedule_[dev] = false; // rate changed: draw a new interval at the new rate
+                continue;
+            }
+        }
+        raise(dev);
+    }
+}
+
+// Controller thread: pick highest-priority unmasked interrupt and run its ISR
+void InterruptController::controller_loop() {
+    PlacementRecord placed = apply_placement("controller", config_.controller_thread);
+    controller_cpu_ = placed.cpu;
+    placement_.add(placed);
+    unique_ptr<PerfGroup> perf;
+    if (config_.perf_counters) {
+        perf.reset(new PerfGroup);
+        lock_guard<mutex> lg(perf_mtx_);
+        perf_.enabled = true;
+        perf_.available = perf->available();
+        perf_.error = perf->error();
+        for (int c = 0; c < PERF_COUNTERS; ++c) perf_.counter_available[c] = perf->available(c);
+        if (!perf->available()) perf.reset();
+    }
+    PerfSample woke, selected, finished;
+
+    Device last_served = PRINTER; // so round-robin starts with KEYBOARD
+    while (running_) {
+        unique_lock<mutex> ul(mtx_);
+        cv_.wait(ul, [this]{ return !pending_.empty() || !running_; });
+        if(!running_ && pending_.empty()) break;
+        if (perf) perf->read(woke);
+
+        int tpr = tpr_.load(memory_order_relaxed);
+        int best_idx = select_next(pending_, masks_, policy_.load(memory_order_relaxed), last_served, tpr);
+        report_blocked_locked(tpr);
+        if (best_idx == -1) {
+            // all pending are masked or below the TPR - wait until masks change or new interrupts arrive
+            cv_.wait_for(ul, chrono::milliseconds(200));
+            continue;
+        }
+
+        // extract event
+        InterruptEvent ev = pending_[best_idx];
+        pending_.erase(best_idx);
+        if (perf) perf->read(selected);
+        auto start = clock_.now();
+        record_dispatch_locked(ev, start);
+        ul.unlock();
+        last_served = ev.dev;
+
+        for (IsrSink *s : sinks_) s->isr_started(ev, start);
+
+        // Simulate ISR work (vary by device)
+        int64_t cost_ns = services_[ev.dev].next_ns();
+        if (kernel_) kernel_->run(cost_ns);
+        else if (cost_ns > 0) this_thread::sleep_for(chrono::nanoseconds(cost_ns));
+
+        auto end = clock_.now();
+        for (IsrSink *s : sinks_) s->isr_finished(ev, start, end);
+        if (perf) {
+            perf->read(finished);
+            lock_guard<mutex> lg(perf_mtx_);
+            perf_.selection.add(woke, selected);
+            perf_.isr[ev.dev].add(selected, finished);
+        }
+        ++dispatched_;
+    }
+}
+
+} // namespace ics
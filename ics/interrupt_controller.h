@@ -0,0 +1,198 @@
+// Interrupt controller: serves the highest-priority pending interrupt that is not masked.
+// Each instance owns its queue, mask register, device threads and controller thread,
+// so several controllers can run side by side in one process.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ics/affinity.h"
+#include "ics/cpu_work.h"
+#include "ics/device_model.h"
+#include "ics/histogram.h"
+#include "ics/isr_sink.h"
+#include "ics/metrics.h"
+#include "ics/pending_queue.h"
+#include "ics/perf_counters.h"
+#include "ics/seqlock.h"
+#include "ics/service.h"
+#include "ics/tsc_clock.h"
+#include "ics/types.h"
+
+namespace ics {
+
+using MaskRegister = std::array<std::atomic<bool>, DEVICE_SLOTS>;
+
+// Picks the oldest unmasked event of each device (by seq), then one of those by
+// policy (FIFO compares their timestamps).
+// last_served only matters for ROUND_ROBIN. Returns an index into events, or -1.
+// A device is eligible when effective_class(d, masks[d]) > tpr (ics/types.h).
+int select_next(const std::vector<InterruptEvent> &events, const MaskRegister &masks,
+                SchedulingPolicy policy = SchedulingPolicy::PRIORITY, Device last_served = PRINTER, int tpr = 0);
+// Same over the controller's structure-of-arrays queue, using the SIMD kernels of
+// ics/pending_queue.h; the result is the same event the vector version would pick
+int select_next(const PendingQueue &pending, const MaskRegister &masks,
+                SchedulingPolicy policy = SchedulingPolicy::PRIORITY, Device last_served = PRINTER, int tpr = 0);
+
+// Chooses among per-device candidates (has[d] = device d has an unmasked pending
+// interrupt raised at time age[d]; FIFO serves the smallest, ties go to the
+// higher-priority device); returns the device or 0 if none.
+int choose_device(const bool *has, const long long *age, SchedulingPolicy policy, Device last_served);
+
+struct ControllerConfig {
+    // ISR service time per device, indexed by Device
+    std::array<ServiceSpec, DEVICE_SLOTS> service{{
+        ServiceSpec(), ServiceSpec::constant_ms(800), ServiceSpec::constant_ms(500), ServiceSpec::constant_ms(300)}};
+    // SLEEP only represents ISR time; COMPUTE/MEMORY burn it on the controller's core
+    IsrWork work = IsrWork::SLEEP;
+    SchedulingPolicy policy = SchedulingPolicy::PRIORITY;
+    // Where the controller and device threads run; applied by each thread as it starts
+    ThreadPlacement controller_thread;
+    std::array<ThreadPlacement, DEVICE_SLOTS> device_threads{};
+    // Sample hardware counters around selection and each ISR on the controller thread
+    bool perf_counters = false;
+    // Clock for event timestamps (raise, ISR start and end); TSC falls back to
+    // steady_clock where it is not invariant
+    TimeSource time_source = TimeSource::STEADY;
+    // Initial task priority register level, 0 to MAX_TPR (ics/types.h)
+    int tpr = 0;
+};
+
+// Counter totals from the controller thread (user-space counts only)
+struct PerfReport {
+    bool enabled = false;                   // ControllerConfig::perf_counters was set
+    bool available = false;                 // the counter group could be opened
+    std::string error;                      // why a counter (or the group) is unavailable
+    std::array<bool, PERF_COUNTERS> counter_available{};
+    PerfTotals selection;                   // wakeup to removal of the chosen event, per dispatch
+    std::array<PerfTotals, DEVICE_SLOTS> isr{}; // ISR section including sink callbacks, per device
+};
+
+struct ControllerStatus {
+    std::array<bool, DEVICE_SLOTS> masked{};
+    int tpr = 0;                // task priority register of the controller CPU
+    int cpu = -1;               // CPU the controller thread runs on, -1 before start()
+    size_t pending = 0;
+    long long dispatched = 0;
+};
+
+class InterruptController {
+public:
+    explicit InterruptController(ControllerConfig config = {});
+    ~InterruptController(); // stops and joins all threads
+    InterruptController(const InterruptController &) = delete;
+    InterruptController &operator=(const InterruptController &) = delete;
+
+    // Sinks are not owned and must outlive the controller. Add before start().
+    void add_sink(IsrSink *sink);
+    // Each device model gets its own thread once start() is called
+    void add_device(std::unique_ptr<DeviceModel> model);
+
+    void start();
+    void stop();
+    bool running() const { return running_; }
+
+    // Queue an interrupt from dev, as a device thread would
+    void raise(Device dev);
+    // Queue interrupts that already carry their raise time (e.g. from another
+    // process) under one lock acquisition; seq is assigned here
+    void raise_batch(const InterruptEvent *events, size_t n);
+    void set_mask(Device dev, bool masked);
+    bool is_masked(Device dev) const { return masks_[dev]; }
+    // Task priority register of the controller CPU: interrupts of class <= level
+    // stay pending until it is lowered. Returns false if level is outside 0..MAX_TPR.
+    bool set_tpr(int level);
+    int tpr() const { return tpr_; }
+    // Runtime changes: the new policy applies to the next selection; a new rate
+    // also cuts short the device's current wait. set_rate returns false if no
+    // model for dev accepts a rate.
+    void set_policy(SchedulingPolicy policy) { policy_ = policy; }
+    SchedulingPolicy policy() const { return policy_; }
+    bool set_rate(Device dev, double hz);
+
+    // Lock-free: both read the published metrics snapshot, never the queue lock
+    ControllerStatus status() const;
+    MetricsSnapshot metrics() const { return published_.load(); }
+    // Full raise-to-ISR-start histogram for dev (takes the queue lock; meant for end-of-run reports)
+    LatencyHistogram latency(Device dev) const;
+    long long dispatched() const { return dispatched_; }
+    // Placement each started thread actually got
+    std::vector<PlacementRecord> placement() const { return placement_.records(); }
+    PerfReport perf_report() const;
+    // Clock actually used for event timestamps, and why TSC was refused if it was
+    TimeSource time_source() const { return clock_.source(); }
+    const std::string &time_source_fallback() const { return clock_.fallback_reason(); }
+
+private:
+    void device_loop(DeviceModel *model);
+    void controller_loop();
+    // Copies metrics_ to published_; caller holds mtx_, which also serializes seqlock writers
+    void publish_locked();
+    // Caller holds mtx_ and pushes the event under the same hold, so every device's
+    // events are queued in seq order whichever thread raises them (report_blocked_locked
+    // relies on it; selection itself takes the smallest seq wherever it sits)
+    long long next_seq(Device dev) { return device_seq(dev, ++seq_[dev]); }
+    // Reports the pending interrupts of masked devices to the sinks and the masked
+    // counter, each interrupt once (the first time a selection passes it over);
+    // interrupts held back only by the TPR go to the deferred counter instead, and
+    // are not counted again if their device is masked later
+    void report_blocked_locked(int tpr);
+    void record_dispatch_locked(const InterruptEvent &ev, std::chrono::steady_clock::time_point start);
+
+    // Members are grouped by who writes them, each group starting on its own cache
+    // line, so per-interrupt writes by device threads do not invalidate the lines
+    // the controller polls (and vice versa).
+
+    // Set up before start(); read-only while running
+    ControllerConfig config_;
+    std::vector<IsrSink *> sinks_;
+    std::vector<std::unique_ptr<DeviceModel>> devices_;
+
+    // Read-mostly: checked on every selection and device wakeup, written only by
+    // console commands, start() and stop()
+    alignas(64) MaskRegister masks_{};
+    std::atomic<int> tpr_;
+    std::atomic<SchedulingPolicy> policy_;
+    std::atomic<bool> running_{false};
+    EventClock clock_;
+    std::atomic<int> controller_cpu_{-1};
+
+    // Producer side: the queue and live metrics, written by every raise() and by
+    // the controller on each removal, all under mtx_
+    alignas(64) mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    PendingQueue pending_;      // searched for the highest-priority unmasked event
+    MetricsSnapshot metrics_;
+    std::array<LatencyHistogram, DEVICE_SLOTS> latency_;
+    std::chrono::steady_clock::time_point quantiles_at_{};
+    // Per-device event counters (device_seq); guarded by mtx_ like the queue they number
+    std::array<long long, DEVICE_SLOTS> seq_{};
+    // Per device: newest seq queued, and newest seq already counted as masked or deferred
+    std::array<long long, DEVICE_SLOTS> newest_{}, reported_{};
+
+    // Published copy for lock-free readers (metrics server, status); written under mtx_
+    alignas(64) Seqlock<MetricsSnapshot> published_;
+
+    // Consumer side: written by the controller thread once per dispatch
+    alignas(64) std::atomic<long long> dispatched_{0};
+
+    // lets device threads sleep between interrupts yet exit promptly on stop() or a rate change
+    alignas(64) std::mutex stop_mtx_;
+    std::condition_variable stop_cv_;
+    std::array<bool, DEVICE_SLOTS> reschedule_{}; // guarded by stop_mtx_
+
+    std::vector<ServiceProcess> services_;   // controller thread only
+    std::unique_ptr<CpuWorkKernel> kernel_;
+    PlacementLog placement_;
+    mutable std::mutex perf_mtx_;
+    PerfReport perf_;
+    std::thread controller_;
+    std::vector<std::thread> device_threads_;
+};
+
+} // namespace ics
@@ -0,0 +1,189 @@
+#include "ics/isr_log.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+#include <system_error>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#include <sys/resource.h>
+#endif
+
+#include "ics/log_codec.h"
+
+using namespace std;
+
+namespace ics {
+
+void lower_thread_priority() {
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__linux__)
+    // SCHED_IDLE and nice apply to the calling thread only on Linux
+    sched_param sp{};
+    if (sched_setscheduler(0, SCHED_IDLE, &sp) != 0) setpriority(PRIO_PROCESS, 0, 19);
+#endif
+}
+
+string format_clock_anchor() {
+    using chrono::nanoseconds;
+    // wall time read between two steady readings and attributed to their midpoint
+    auto a = chrono::steady_clock::now();
+    auto wall = chrono::system_clock::now();
+    auto b = chrono::steady_clock::now();
+    int64_t steady = chrono::duration_cast<nanoseconds>(a.time_since_epoch() + (b - a) / 2).count();
+    int64_t wall_ns = chrono::duration_cast<nanoseconds>(wall.time_since_epoch()).count();
+    return "# clock steady_ns=" + to_string(steady) + " wall_ns=" + to_string(wall_ns);
+}
+
+bool parse_clock_anchor(const string &line, int64_t &steady_ns, int64_t &wall_ns) {
+    long long s, w;
+    if (sscanf(line.c_str(), "# clock steady_ns=%lld wall_ns=%lld", &s, &w) != 2) return false;
+    steady_ns = s;
+    wall_ns = w;
+    return true;
+}
+
+string raw_time_to_wall(const string &line, int64_t steady_ns, int64_t wall_ns) {
+    size_t at = line.rfind("| t=");
+    if (at == string::npos) return line;
+    char *end;
+    long long t = strtoll(line.c_str() + at + 4, &end, 10);
+    if (*end) return line;
+    int64_t wall = wall_ns + (t - steady_ns);
+    chrono::system_clock::time_point tp(chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(wall)));
+    char us[8];
+    snprintf(us, sizeof(us), ".%06d", (int)((wall % 1000000000 + 1000000000) % 1000000000 / 1000));
+    return line.substr(0, at + 2) + format_local_time(tp) + us;
+}
+
+// Highest N among existing "<path>.N" and "<path>.N.icz" segments, 0 if none
+static int last_segment(const string &path) {
+    namespace fs = std::filesystem;
+    fs::path p(path);
+    fs::path dir = p.has_parent_path() ? p.parent_path() : fs::path(".");
+    string prefix = p.filename().string() + ".";
+    int last = 0;
+    error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        string name = it->path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) != 0) continue;
+        char *tail;
+        long n = strtol(name.c_str() + prefix.size(), &tail, 10);
+        if (tail != name.c_str() + prefix.size() && n > last && (!*tail || string(tail) == ".icz")) last = (int)n;
+    }
+    return last;
+}
+
+IsrLog::IsrLog(LogOptions options) : options_(move(options)) {
+    {
+        lock_guard<mutex> lg(mtx_);
+        segment_ = last_segment(options_.path); // continue numbering after an earlier run's segments
+        open_segment(ios::trunc);
+    }
+    compressor_ = thread(&IsrLog::compressor_loop, this);
+}
+
+IsrLog::~IsrLog() {
+    {
+        lock_guard<mutex> lg(mtx_);
+        file_.close();
+    }
+    {
+        lock_guard<mutex> lg(compress_mtx_);
+        compress_done_ = true;
+    }
+    compress_cv_.notify_one();
+    compressor_.join();
+}
+
+void IsrLog::open_segment(ios::openmode mode) {
+    file_.open(options_.path, mode);
+    opened_ = chrono::steady_clock::now();
+    bytes_ = 0; // after a failed rotation (append mode) this restarts the size count
+    if (file_ && (mode & ios::trunc)) {
+        string header = "ISR Log Started: " + to_string(chrono::system_clock::to_time_t(chrono::system_clock::now()));
+        if (options_.raw_time) header += "\n" + format_clock_anchor();
+        file_ << header << "\n";
+        bytes_ = header.size() + 1;
+    }
+}
+
+// Called with mtx_ held. Only renames the file; compression happens on the background thread.
+// If the rename fails, the active file keeps growing and the next rotation is
+// tried after another full segment.
+void IsrLog::rotate() {
+    file_.close();
+    string closed = options_.path + "." + to_string(segment_ + 1);
+    if (rename(options_.path.c_str(), closed.c_str()) != 0) {
+        open_segment(ios::app);
+        return;
+    }
+    ++segment_;
+    if (options_.compress) {
+        {
+            lock_guard<mutex> lg(compress_mtx_);
+            compress_queue_.push_back(closed);
+        }
+        compress_cv_.notify_one();
+    }
+    open_segment(ios::trunc);
+}
+
+void IsrLog::append(const string &line) {
+    lock_guard<mutex> lg(mtx_);
+    bool due = (options_.max_bytes && bytes_ + line.size() + 1 > options_.max_bytes && bytes_ > 0) ||
+               (options_.rotate_sec && chrono::steady_clock::now() - opened_ >= chrono::seconds(options_.rotate_sec));
+    if (due) rotate();
+    if(file_) {
+        file_ << line << "\n";
+        file_.flush();
+        bytes_ += line.size() + 1;
+    }
+}
+
+void IsrLog::isr_started(const InterruptEvent &ev, time_point start) {
+    stringstream ss;
+    ss << "START | " << device_name(ev.dev) << " | seq=" << ev.seq << " | ";
+    if (options_.raw_time) ss << "t=" << start.time_since_epoch().count();
+    else ss << format_local_time(chrono::system_clock::now());
+    append(ss.str());
+}
+
+void IsrLog::isr_finished(const InterruptEvent &ev, time_point, time_point end) {
+    stringstream ss;
+    ss << "END   | " << device_name(ev.dev) << " | seq=" << ev.seq << " | ";
+    if (options_.raw_time) ss << "t=" << end.time_since_epoch().count();
+    else ss << format_local_time(chrono::system_clock::now());
+    append(ss.str());
+}
+
+// Compresses closed segments to "<segment>.icz" and removes the plain copy
+void IsrLog::compressor_loop() {
+    lower_thread_priority();
+    unique_lock<mutex> ul(compress_mtx_);
+    for (;;) {
+        compress_cv_.wait(ul, [this]{ return !compress_queue_.empty() || compress_done_; });
+        if (compress_queue_.empty()) break; // done and drained
+        string path = compress_queue_.front();
+        compress_queue_.pop_front();
+        ul.unlock();
+
+        string packed = path + ".icz";
+        bool ok;
+        {
+            ifstream in(path, ios::binary);
+            ofstream out(packed, ios::binary | ios::trunc);
+            ok = in && out && log_codec::compress_stream(in, out);
+        }
+        if (ok) remove(path.c_str());
+        else remove(packed.c_str());
+
+        ul.lock();
+    }
+}
+
+} // namespace ics
@@ -0,0 +1,76 @@
+// ISR log: START/END lines per dispatched interrupt, with rotation by size and/or
+// interval into numbered segments (path.1, path.2, ...). Closed segments are
+// compressed to "<segment>.icz" by a low-priority background thread, so rotation
+// itself only costs a rename on the controller path.
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "ics/isr_sink.h"
+
+namespace ics {
+
+struct LogOptions {
+    std::string path = "isr_log.txt";
+    size_t max_bytes = 0;   // 0 = no size-based rotation
+    int rotate_sec = 0;     // 0 = no time-based rotation
+    bool compress = true;
+    // Write ISR start/end as steady-clock ns ("t=...") instead of formatting wall
+    // time per line; each segment's header anchors steady to wall time, and
+    // "isr_log_tool cat" converts on the way out
+    bool raw_time = false;
+};
+
+class IsrLog : public IsrSink {
+public:
+    // Truncates options.path; segments number on from any already on disk
+    explicit IsrLog(LogOptions options = {});
+    ~IsrLog() override;                       // closes and drains the compressor
+    IsrLog(const IsrLog &) = delete;
+    IsrLog &operator=(const IsrLog &) = delete;
+
+    void append(const std::string &line);
+    const std::string &path() const { return options_.path; }
+
+    void isr_started(const InterruptEvent &ev, time_point start) override;
+    void isr_finished(const InterruptEvent &ev, time_point start, time_point end) override;
+
+private:
+    void open_segment(std::ios::openmode mode);
+    void rotate();
+    void compressor_loop();
+
+    LogOptions options_;
+
+    std::mutex mtx_;
+    std::ofstream file_;
+    size_t bytes_ = 0;                      // bytes written to the active segment
+    std::chrono::steady_clock::time_point opened_;
+    int segment_ = 0;                       // number of the last closed segment
+
+    std::mutex compress_mtx_;
+    std::condition_variable compress_cv_;
+    std::deque<std::string> compress_queue_;
+    bool compress_done_ = false;
+    std::thread compressor_;
+};
+
+// Raw-time logs: "# clock steady_ns=S wall_ns=W" pairs a steady-clock reading
+// with the wall-clock time at the same moment
+std::string format_clock_anchor();
+bool parse_clock_anchor(const std::string &line, int64_t &steady_ns, int64_t &wall_ns);
+// Rewrites a trailing "t=<steady ns>" as local wall time with microseconds
+// ("2025-10-25 01:55:58.123456"); other lines are returned unchanged
+std::string raw_time_to_wall(const std::string &line, int64_t steady_ns, int64_t wall_ns);
+
+// Lowers the calling thread's scheduling priority (SCHED_IDLE / nice 19 / THREAD_PRIORITY_LOWEST)
+void lower_thread_priority();
+
+} // namespace ics
@@ -0,0 +1,26 @@
+// Observers of controller activity (console, ISR log, trace export, ...).
+// Callbacks run on the controller thread, except mask_changed which runs on
+// the caller of InterruptController::set_mask; implementations must be thread-safe
+// and should stay cheap, since they run on the dispatch path.
+#pragma once
+
+#include <chrono>
+
+#include "ics/types.h"
+
+namespace ics {
+
+class IsrSink {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    virtual ~IsrSink() = default;
+    virtual void isr_started(const InterruptEvent &ev, time_point start) { (void)ev; (void)start; }
+    virtual void isr_finished(const InterruptEvent &ev, time_point start, time_point end) { (void)ev; (void)start; (void)end; }
+    // A pending interrupt was passed over because its device is masked; called
+    // once per interrupt, however long it stays pending
+    virtual void interrupt_masked(const InterruptEvent &ev) { (void)ev; }
+    virtual void mask_changed(Device dev, bool masked) { (void)dev; (void)masked; }
+};
+
+} // namespace ics
@@ -0,0 +1,182 @@
+/*
+log_codec.h - small LZ4-style codec used for rotated ISR log segments.
+
+Container format (all integers little-endian):
+    "ICZ1"                              magic
+    repeated blocks:
+        u32 raw_len                     bytes of original data in this block (0 = end), <= BLOCK_SIZE
+        u32 stored_len                  bytes that follow, <= raw_len (blocks that would not shrink
+                                        are stored as is); high bit set = stored uncompressed
+        stored_len bytes of payload
+
+Block payload is a sequence of LZ4-like records:
+    token (hi nibble = literal length, lo nibble = match length - 4, 15 = extended)
+    [extra literal length bytes] literals [u16 offset] [extra match length bytes]
+The last record of a block carries literals only.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace log_codec {
+
+const size_t BLOCK_SIZE = 64 * 1024;
+const size_t MIN_MATCH = 4;
+const uint32_t STORED_RAW = 0x80000000u;
+const char MAGIC[4] = {'I', 'C', 'Z', '1'};
+
+inline void put_u32(std::string &out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(char((v >> (8 * i)) & 0xff));
+}
+
+inline bool get_u32(std::istream &in, uint32_t &v) {
+    unsigned char b[4];
+    if (!in.read(reinterpret_cast<char *>(b), 4)) return false;
+    v = uint32_t(b[0]) | (uint32_t(b[1]) << 8) | (uint32_t(b[2]) << 16) | (uint32_t(b[3]) << 24);
+    return true;
+}
+
+inline void put_length(std::string &out, size_t len) {
+    while (len >= 255) { out.push_back(char(255)); len -= 255; }
+    out.push_back(char(len));
+}
+
+inline void emit_record(std::string &out, const char *lit, size_t lit_len, size_t match_len, size_t offset) {
+    size_t ml = match_len ? match_len - MIN_MATCH : 0;
+    unsigned char token = (unsigned char)(((lit_len < 15 ? lit_len : 15) << 4) | (ml < 15 ? ml : 15));
+    out.push_back(char(token));
+    if (lit_len >= 15) put_length(out, lit_len - 15);
+    out.append(lit, lit_len);
+    if (!match_len) return;
+    out.push_back(char(offset & 0xff));
+    out.push_back(char((offset >> 8) & 0xff));
+    if (ml >= 15) put_length(out, ml - 15);
+}
+
+// Greedy single-probe hash matcher; fast rather than tight, log text compresses well anyway.
+inline std::string compress_block(const char *src, size_t n) {
+    const int HASH_BITS = 12;
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, UINT32_MAX);
+    std::string out;
+    out.reserve(n / 2 + 16);
+
+    size_t anchor = 0, i = 0;
+    while (i + MIN_MATCH <= n) {
+        uint32_t word;
+        memcpy(&word, src + i, 4);
+        uint32_t h = (word * 2654435761u) >> (32 - HASH_BITS);
+        uint32_t cand = table[h];
+        table[h] = (uint32_t)i;
+        if (cand != UINT32_MAX && i - cand <= 0xffff && memcmp(src + cand, src + i, MIN_MATCH) == 0) {
+            size_t len = MIN_MATCH;
+            while (i + len < n && src[cand + len] == src[i + len]) ++len;
+            emit_record(out, src + anchor, i - anchor, len, i - cand);
+            i += len;
+            anchor = i;
+        } else {
+            ++i;
+        }
+    }
+    emit_record(out, src + anchor, n - anchor, 0, 0);
+    return out;
+}
+
+// Returns false on malformed input, or once out would grow past limit bytes.
+inline bool decompress_block(const char *src, size_t n, std::string &out, size_t limit = SIZE_MAX) {
+    size_t i = 0;
+    auto read_length = [&](size_t &len) {
+        unsigned char b;
+        do {
+            if (i >= n) return false;
+            b = (unsigned char)src[i++];
+            len += b;
+        } while (b == 255);
+        return true;
+    };
+    while (i < n) {
+        unsigned char token = (unsigned char)src[i++];
+        size_t lit_len = token >> 4;
+        if (lit_len == 15 && !read_length(lit_len)) return false;
+        if (i + lit_len > n || lit_len > limit - out.size()) return false;
+        out.append(src + i, lit_len);
+        i += lit_len;
+        if (i == n) break; // final literal-only record
+
+        if (i + 2 > n) return false;
+        size_t offset = (unsigned char)src[i] | ((size_t)(unsigned char)src[i + 1] << 8);
+        i += 2;
+        size_t match_len = token & 15;
+        if (match_len == 15 && !read_length(match_len)) return false;
+        match_len += MIN_MATCH;
+        if (offset == 0 || offset > out.size() || match_len > limit - out.size()) return false;
+        size_t from = out.size() - offset;
+        for (size_t k = 0; k < match_len; ++k) out.push_back(out[from + k]); // may overlap
+    }
+    return true;
+}
+
+inline bool compress_stream(std::istream &in, std::ostream &out) {
+    out.write(MAGIC, 4);
+    std::vector<char> buf(BLOCK_SIZE);
+    std::string header;
+    while (in) {
+        in.read(buf.data(), (std::streamsize)buf.size());
+        size_t got = (size_t)in.gcount();
+        if (!got) break;
+        std::string packed = compress_block(buf.data(), got);
+        bool raw = packed.size() >= got;
+        header.clear();
+        put_u32(header, (uint32_t)got);
+        put_u32(header, raw ? (uint32_t)got | STORED_RAW : (uint32_t)packed.size());
+        out.write(header.data(), (std::streamsize)header.size());
+        if (raw) out.write(buf.data(), (std::streamsize)got);
+        else out.write(packed.data(), (std::streamsize)packed.size());
+    }
+    header.clear();
+    put_u32(header, 0);
+    put_u32(header, 0);
+    out.write(header.data(), (std::streamsize)header.size());
+    return bool(out);
+}
+
+// Expects the magic to be present; returns false on truncated or corrupt input.
+inline bool decompress_stream(std::istream &in, std::ostream &out) {
+    char magic[4];
+    if (!in.read(magic, 4) || memcmp(magic, MAGIC, 4) != 0) return false;
+    std::vector<char> payload;
+    std::string block;
+    for (;;) {
+        uint32_t raw_len, stored_len;
+        if (!get_u32(in, raw_len) || !get_u32(in, stored_len)) return false;
+        if (raw_len == 0) return true;
+        bool raw = (stored_len & STORED_RAW) != 0;
+        stored_len &= ~STORED_RAW;
+        // checked before stored_len sizes anything: the encoder never writes a longer block,
+        // nor a payload longer than its raw data, so corrupt headers cost no memory
+        if (raw_len > BLOCK_SIZE || stored_len > raw_len || (raw && stored_len != raw_len)) return false;
+        payload.resize(stored_len);
+        if (!in.read(payload.data(), stored_len)) return false;
+        if (raw) {
+            out.write(payload.data(), stored_len);
+            continue;
+        }
+        block.clear();
+        if (!decompress_block(payload.data(), stored_len, block, raw_len) || block.size() != raw_len) return false;
+        out.write(block.data(), (std::streamsize)block.size());
+    }
+}
+
+inline bool is_compressed(std::istream &in) {
+    char magic[4];
+    bool ok = bool(in.read(magic, 4)) && memcmp(magic, MAGIC, 4) == 0;
+    in.clear();
+    in.seekg(0);
+    return ok;
+}
+
+} // namespace log_codec
@@ -0,0 +1,67 @@
+#include "ics/metrics.h"
+
+#include <cstdio>
+
+using namespace std;
+
+namespace ics {
+
+namespace {
+
+void header(string &out, const char *name, const char *type, const char *help) {
+    out += string("# HELP ") + name + " " + help + "\n";
+    out += string("# TYPE ") + name + " " + type + "\n";
+}
+
+void sample(string &out, const string &name, const string &labels, double value) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.10g", value);
+    out += labels.empty() ? name : name + "{" + labels + "}";
+    out += string(" ") + buf + "\n";
+}
+
+string device_label(Device d) {
+    return "device=\"" + device_name(d) + "\"";
+}
+
+} // namespace
+
+string format_prometheus(const MetricsSnapshot &m) {
+    string out;
+    header(out, "ics_interrupts_raised_total", "counter", "Interrupts raised by each device.");
+    for (Device d : ALL_DEVICES) sample(out, "ics_interrupts_raised_total", device_label(d), m.devices[d].arrivals);
+    header(out, "ics_interrupts_dispatched_total", "counter", "Interrupts handed to an ISR.");
+    for (Device d : ALL_DEVICES) sample(out, "ics_interrupts_dispatched_total", device_label(d), m.devices[d].dispatched);
+    header(out, "ics_interrupts_masked_total", "counter",
+           "Pending interrupts held back by the device mask, each counted once and never also as deferred.");
+    for (Device d : ALL_DEVICES) sample(out, "ics_interrupts_masked_total", device_label(d), m.devices[d].masked);
+    header(out, "ics_interrupts_deferred_total", "counter",
+           "Unmasked pending interrupts held back by the task priority register, each counted once and never also as masked.");
+    for (Device d : ALL_DEVICES) sample(out, "ics_interrupts_deferred_total", device_label(d), m.devices[d].deferred);
+    header(out, "ics_queue_depth", "gauge", "Pending interrupts.");
+    for (Device d : ALL_DEVICES) sample(out, "ics_queue_depth", device_label(d), m.devices[d].queue_depth);
+    header(out, "ics_device_masked", "gauge", "1 if the device is masked.");
+    for (Device d : ALL_DEVICES) sample(out, "ics_device_masked", device_label(d), m.devices[d].mask ? 1 : 0);
+    header(out, "ics_task_priority", "gauge", "Controller task priority register; classes at or below it are held back.");
+    sample(out, "ics_task_priority", "", m.tpr);
+    header(out, "ics_isr_completed_total", "counter", "ISRs completed, all devices.");
+    sample(out, "ics_isr_completed_total", "", m.dispatched);
+
+    header(out, "ics_dispatch_latency_seconds", "summary", "Time from raise to ISR start.");
+    for (Device d : ALL_DEVICES) {
+        const DeviceMetrics &dm = m.devices[d];
+        for (int q = 0; q < METRIC_QUANTILE_COUNT; ++q) {
+            char quantile[32];
+            snprintf(quantile, sizeof(quantile), "%g", METRIC_QUANTILES[q]);
+            sample(out, "ics_dispatch_latency_seconds", device_label(d) + ",quantile=\"" + quantile + "\"",
+                   dm.latency_ns[q] / 1e9);
+        }
+        sample(out, "ics_dispatch_latency_seconds_sum", device_label(d), dm.latency_sum_ns / 1e9);
+        sample(out, "ics_dispatch_latency_seconds_count", device_label(d), dm.latency_count);
+    }
+    header(out, "ics_dispatch_latency_max_seconds", "gauge", "Largest raise-to-ISR-start time so far.");
+    for (Device d : ALL_DEVICES) sample(out, "ics_dispatch_latency_max_seconds", device_label(d), m.devices[d].latency_max_ns / 1e9);
+    return out;
+}
+
+} // namespace ics
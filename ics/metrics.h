@@ -0,0 +1,43 @@
+// Live controller metrics. The controller updates a MetricsSnapshot under its
+// queue lock and publishes it through a seqlock, so observers (the status
+// command, the metrics endpoint) read it without touching that lock.
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "ics/types.h"
+
+namespace ics {
+
+// Quantiles published for dispatch latency (raise to ISR start)
+const double METRIC_QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+const int METRIC_QUANTILE_COUNT = 4;
+
+struct DeviceMetrics {
+    uint64_t arrivals = 0;          // interrupts raised
+    uint64_t dispatched = 0;        // handed to an ISR
+    uint64_t masked = 0;            // pending interrupts held back by the mask, each counted once
+    uint64_t deferred = 0;          // unmasked pending interrupts held back by the TPR, each counted once;
+                                    // an interrupt held by both counts under whichever applied first
+    uint64_t queue_depth = 0;       // pending now
+    bool mask = false;              // mask register bit
+    uint64_t latency_count = 0;
+    double latency_sum_ns = 0;
+    int64_t latency_max_ns = 0;
+    int64_t latency_ns[METRIC_QUANTILE_COUNT] = {};
+};
+
+struct MetricsSnapshot {
+    uint64_t version = 0;           // bumped on every publish
+    uint64_t dispatched = 0;        // ISRs completed
+    uint64_t queue_depth = 0;
+    int tpr = 0;                    // controller task priority register
+    std::array<DeviceMetrics, DEVICE_SLOTS> devices{};
+};
+
+// Prometheus text exposition format (version 0.0.4)
+std::string format_prometheus(const MetricsSnapshot &m);
+
+} // namespace ics
@@ -0,0 +1,94 @@
+#include "ics/metrics_server.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace ics {
+
+// How often the accept loop checks for stop(), and how long a client may take to send its request
+static const int POLL_MS = 200;
+static const int REQUEST_WAIT_MS = 100;
+
+MetricsServer::MetricsServer(string path, Source source) : path_(move(path)), source_(move(source)) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(string &error) {
+    if (running_) return true;
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path_.size() >= sizeof(addr.sun_path)) {
+        error = path_ + ": socket path too long";
+        return false;
+    }
+    strcpy(addr.sun_path, path_.c_str());
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        error = string("socket: ") + strerror(errno);
+        return false;
+    }
+    unlink(path_.c_str()); // left behind by an earlier run
+    if (bind(listen_fd_, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listen_fd_, 8) != 0) {
+        error = path_ + ": " + strerror(errno);
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    running_ = true;
+    thread_ = thread(&MetricsServer::serve, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!running_) return;
+    running_ = false;
+    thread_.join();
+    close(listen_fd_);
+    listen_fd_ = -1;
+    unlink(path_.c_str());
+}
+
+static void write_all(int fd, const string &data) {
+    size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = send(fd, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return;
+        }
+        off += n;
+    }
+}
+
+void MetricsServer::serve() {
+    while (running_) {
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        if (poll(&pfd, 1, POLL_MS) <= 0) continue;
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+
+        // drain whatever request line the client sends; plain readers send nothing
+        pollfd cfd{fd, POLLIN, 0};
+        if (poll(&cfd, 1, REQUEST_WAIT_MS) > 0) {
+            char buf[1024];
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            (void)n;
+        }
+
+        string body = format_prometheus(source_());
+        write_all(fd, "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                          to_string(body.size()) + "\r\n\r\n" + body);
+        close(fd);
+    }
+}
+
+} // namespace ics
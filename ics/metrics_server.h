@@ -0,0 +1,41 @@
+// Serves Prometheus text on a Unix domain socket. Each connection gets one
+// HTTP/1.0 response and is closed, so "curl --unix-socket PATH http://x/metrics"
+// (or a socat bridge for a TCP scraper) works, and so does a bare "nc -U PATH".
+// The server thread only reads the published snapshot; it never takes the
+// controller's locks.
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "ics/metrics.h"
+
+namespace ics {
+
+class MetricsServer {
+public:
+    using Source = std::function<MetricsSnapshot()>;
+
+    MetricsServer(std::string path, Source source);
+    ~MetricsServer(); // stops and removes the socket file
+    MetricsServer(const MetricsServer &) = delete;
+    MetricsServer &operator=(const MetricsServer &) = delete;
+
+    // Binds the socket (replacing a stale one) and starts serving
+    bool start(std::string &error);
+    void stop();
+    const std::string &path() const { return path_; }
+
+private:
+    void serve();
+
+    std::string path_;
+    Source source_;
+    int listen_fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
+
+} // namespace ics
@@ -0,0 +1,32 @@
+// Minimal fork-join helper for embarrassingly parallel work (sweeps, replications).
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace ics {
+
+inline unsigned default_thread_count() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+// Calls fn(i) for every i in [0, n) on up to `threads` workers; items are claimed
+// dynamically so uneven work balances itself. fn must be safe to call concurrently.
+template <class Fn>
+void parallel_for(size_t n, unsigned threads, Fn fn) {
+    if (threads == 0) threads = default_thread_count();
+    if (threads > n) threads = (unsigned)n;
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i; (i = next.fetch_add(1)) < n;) fn(i);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker(); // the calling thread works too
+    for (auto &t : pool) t.join();
+}
+
+} // namespace ics
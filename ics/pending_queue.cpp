@@ -0,0 +1,169 @@
+#include "ics/pending_queue.h"
+
+#include <atomic>
+#include <climits>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define ICS_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace ics {
+
+static const size_t SIMD_MIN_ENTRIES = 16;
+
+static void oldest_scalar(const uint8_t *dev, const long long *seq, size_t n, long long *oldest) {
+    for (size_t i = 0; i < n; ++i)
+        if (seq[i] < oldest[dev[i]]) oldest[dev[i]] = seq[i];
+}
+
+static int find_scalar(const long long *seq, size_t n, long long value) {
+    for (size_t i = 0; i < n; ++i)
+        if (seq[i] == value) return (int)i;
+    return -1;
+}
+
+#ifdef ICS_SIMD_X86
+
+// 4 lanes of int64; AVX2 has no 64-bit min, so compare and blend
+__attribute__((target("avx2"))) static void oldest_avx2(const uint8_t *dev, const long long *seq, size_t n,
+                                                         long long *oldest) {
+    const __m256i none = _mm256_set1_epi64x(LLONG_MAX);
+    __m256i acc[DEVICE_SLOTS] = {none, none, none, none};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int32_t d4;
+        memcpy(&d4, dev + i, 4);
+        __m256i d = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(d4));
+        __m256i s = _mm256_loadu_si256((const __m256i *)(seq + i));
+        for (Device k : ALL_DEVICES) {
+            __m256i mine = _mm256_blendv_epi8(none, s, _mm256_cmpeq_epi64(d, _mm256_set1_epi64x(k)));
+            acc[k] = _mm256_blendv_epi8(acc[k], mine, _mm256_cmpgt_epi64(acc[k], mine));
+        }
+    }
+    for (Device k : ALL_DEVICES) {
+        alignas(32) long long lanes[4];
+        _mm256_store_si256((__m256i *)lanes, acc[k]);
+        for (long long v : lanes)
+            if (v < oldest[k]) oldest[k] = v;
+    }
+    oldest_scalar(dev + i, seq + i, n - i, oldest);
+}
+
+__attribute__((target("avx2"))) static int find_avx2(const long long *seq, size_t n, long long value) {
+    const __m256i v = _mm256_set1_epi64x(value);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int hit = _mm256_movemask_pd(_mm256_castsi256_pd(
+            _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)(seq + i)), v)));
+        if (hit) return (int)i + __builtin_ctz(hit);
+    }
+    int j = find_scalar(seq + i, n - i, value);
+    return j < 0 ? -1 : (int)i + j;
+}
+
+// 8 lanes of int64 with a masked min, two vectors (16 entries) per iteration
+__attribute__((target("avx512f"))) static void oldest_avx512(const uint8_t *dev, const long long *seq, size_t n,
+                                                              long long *oldest) {
+    const __m512i none = _mm512_set1_epi64(LLONG_MAX);
+    __m512i acc[DEVICE_SLOTS] = {none, none, none, none};
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        // no undefined vectors anywhere (the upper half of the load, or the pass-through
+        // of the unmasked widen): GCC's LTO link warns about them as uninitialized
+        int64_t d8[2];
+        memcpy(d8, dev + i, sizeof(d8));
+        __m512i d0 = _mm512_maskz_cvtepu8_epi64(0xff, _mm_cvtsi64_si128(d8[0]));
+        __m512i d1 = _mm512_maskz_cvtepu8_epi64(0xff, _mm_cvtsi64_si128(d8[1]));
+        __m512i s0 = _mm512_loadu_si512(seq + i);
+        __m512i s1 = _mm512_loadu_si512(seq + i + 8);
+        for (Device k : ALL_DEVICES) {
+            __m512i key = _mm512_set1_epi64(k);
+            acc[k] = _mm512_mask_min_epi64(acc[k], _mm512_cmpeq_epi64_mask(d0, key), acc[k], s0);
+            acc[k] = _mm512_mask_min_epi64(acc[k], _mm512_cmpeq_epi64_mask(d1, key), acc[k], s1);
+        }
+    }
+    for (Device k : ALL_DEVICES) {
+        alignas(64) long long lanes[8];
+        _mm512_store_si512(lanes, acc[k]);
+        for (long long v : lanes)
+            if (v < oldest[k]) oldest[k] = v;
+    }
+    oldest_scalar(dev + i, seq + i, n - i, oldest);
+}
+
+__attribute__((target("avx512f"))) static int find_avx512(const long long *seq, size_t n, long long value) {
+    const __m512i v = _mm512_set1_epi64(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __mmask8 hit = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(seq + i), v);
+        if (hit) return (int)i + __builtin_ctz(hit);
+    }
+    int j = find_scalar(seq + i, n - i, value);
+    return j < 0 ? -1 : (int)i + j;
+}
+
+#endif
+
+const char *simd_name(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+SimdLevel simd_supported() {
+#ifdef ICS_SIMD_X86
+    static const SimdLevel best = __builtin_cpu_supports("avx512f") ? SimdLevel::AVX512
+                                  : __builtin_cpu_supports("avx2") ? SimdLevel::AVX2
+                                                                    : SimdLevel::SCALAR;
+    return best;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+static atomic<SimdLevel> &active_level() {
+    static atomic<SimdLevel> level{simd_supported()};
+    return level;
+}
+
+SimdLevel simd_level() {
+    return active_level().load(memory_order_relaxed);
+}
+
+void set_simd_level(SimdLevel level) {
+    if (level > simd_supported()) level = simd_supported();
+    active_level().store(level, memory_order_relaxed);
+}
+
+void oldest_per_device(const uint8_t *dev, const long long *seq, size_t n, const bool *masked,
+                       long long oldest[DEVICE_SLOTS]) {
+    for (int d = 0; d < DEVICE_SLOTS; ++d) oldest[d] = LLONG_MAX;
+    // below a couple of vectors the reductions cost more than they save
+    switch (n < SIMD_MIN_ENTRIES ? SimdLevel::SCALAR : simd_level()) {
+#ifdef ICS_SIMD_X86
+        case SimdLevel::AVX512: oldest_avx512(dev, seq, n, oldest); break;
+        case SimdLevel::AVX2: oldest_avx2(dev, seq, n, oldest); break;
+#endif
+        default: oldest_scalar(dev, seq, n, oldest); break;
+    }
+    for (int d = 0; d < DEVICE_SLOTS; ++d)
+        if (masked[d]) oldest[d] = LLONG_MAX;
+}
+
+int find_seq(const long long *seq, size_t n, long long value) {
+    switch (simd_level()) {
+#ifdef ICS_SIMD_X86
+        case SimdLevel::AVX512: return find_avx512(seq, n, value);
+        case SimdLevel::AVX2: return find_avx2(seq, n, value);
+#endif
+        default: return find_scalar(seq, n, value);
+    }
+}
+
+} // namespace ics
@@ -0,0 +1,61 @@
+// Pending interrupts of the threaded controller, kept as a structure of arrays
+// (devices, sequence numbers, timestamps) so selection scans contiguous lanes
+// with SIMD. Order is not preserved: erase() moves the last entry into the hole,
+// which is fine because age is decided by seq alone.
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ics/types.h"
+
+namespace ics {
+
+class PendingQueue {
+public:
+    void push_back(const InterruptEvent &ev) {
+        dev_.push_back((uint8_t)ev.dev);
+        seq_.push_back(ev.seq);
+        timestamp_.push_back(ev.timestamp);
+    }
+    InterruptEvent operator[](size_t i) const { return {(Device)dev_[i], seq_[i], timestamp_[i]}; }
+    void erase(size_t i) {
+        dev_[i] = dev_.back();
+        seq_[i] = seq_.back();
+        timestamp_[i] = timestamp_.back();
+        dev_.pop_back();
+        seq_.pop_back();
+        timestamp_.pop_back();
+    }
+    size_t size() const { return seq_.size(); }
+    bool empty() const { return seq_.empty(); }
+
+    const uint8_t *devs() const { return dev_.data(); }
+    const long long *seqs() const { return seq_.data(); }
+    std::chrono::steady_clock::time_point timestamp(size_t i) const { return timestamp_[i]; }
+
+private:
+    std::vector<uint8_t> dev_;
+    std::vector<long long> seq_;
+    std::vector<std::chrono::steady_clock::time_point> timestamp_;
+};
+
+// Selection kernels: chosen once at startup from what the CPU supports
+enum class SimdLevel { SCALAR, AVX2, AVX512 };
+
+const char *simd_name(SimdLevel level);
+SimdLevel simd_supported();
+SimdLevel simd_level();
+// Forces a level (clamped to simd_supported()), e.g. to benchmark the fallbacks
+void set_simd_level(SimdLevel level);
+
+// oldest[d] = smallest seq of device d among the n entries (LLONG_MAX if none);
+// masked devices are skipped
+void oldest_per_device(const uint8_t *dev, const long long *seq, size_t n, const bool *masked,
+                       long long oldest[DEVICE_SLOTS]);
+// Index of the entry whose seq is value, or -1
+int find_seq(const long long *seq, size_t n, long long value);
+
+} // namespace ics
@@ -0,0 +1,95 @@
+#include "ics/perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace ics {
+
+const char *perf_counter_name(int c) {
+    switch (c) {
+        case PERF_CYCLES: return "cycles";
+        case PERF_INSTRUCTIONS: return "instructions";
+        case PERF_CACHE_MISSES: return "cache-misses";
+        case PERF_BRANCH_MISSES: return "branch-misses";
+        default: return "?";
+    }
+}
+
+void PerfTotals::add(const PerfSample &before, const PerfSample &after) {
+    ++sections;
+    for (int c = 0; c < PERF_COUNTERS; ++c) sum[c] += after.value[c] - before.value[c];
+}
+
+#ifdef __linux__
+
+static int open_counter(uint64_t config, int group_fd) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.disabled = group_fd == -1; // the leader starts the whole group
+    return (int)syscall(SYS_perf_event_open, &attr, 0 /* this thread */, -1, group_fd, 0);
+}
+
+PerfGroup::PerfGroup() {
+    fds_.fill(-1);
+    slot_.fill(-1);
+    static const uint64_t configs[PERF_COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int c = 0; c < PERF_COUNTERS; ++c) {
+        int fd = open_counter(configs[c], fds_[PERF_CYCLES]);
+        if (fd < 0) {
+            if (error_.empty()) error_ = string(perf_counter_name(c)) + ": " + strerror(errno);
+            if (c == PERF_CYCLES) return; // no leader, no group
+            continue;
+        }
+        fds_[c] = fd;
+        slot_[c] = members_++;
+    }
+    ioctl(fds_[PERF_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds_[PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+PerfGroup::~PerfGroup() {
+    for (int fd : fds_)
+        if (fd >= 0) close(fd);
+}
+
+bool PerfGroup::read(PerfSample &s) const {
+    if (!available()) return false;
+    uint64_t buf[1 + PERF_COUNTERS]; // nr, then one value per member
+    ssize_t n = ::read(fds_[PERF_CYCLES], buf, sizeof(buf));
+    if (n < (ssize_t)sizeof(uint64_t) || buf[0] != (uint64_t)members_) return false;
+    for (int c = 0; c < PERF_COUNTERS; ++c) s.value[c] = slot_[c] >= 0 ? buf[1 + slot_[c]] : 0;
+    return true;
+}
+
+#else
+
+PerfGroup::PerfGroup() : error_("perf events need Linux") {
+    fds_.fill(-1);
+    slot_.fill(-1);
+}
+
+PerfGroup::~PerfGroup() {}
+
+bool PerfGroup::read(PerfSample &) const {
+    return false;
+}
+
+#endif
+
+} // namespace ics
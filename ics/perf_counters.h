@@ -0,0 +1,55 @@
+// Hardware performance counters for the calling thread (Linux perf_event_open).
+// One group - cycles, instructions, cache misses, branch misses - is read with a
+// single read() per sample, so the counters in a sample cover the same interval.
+// User-space only (exclude_kernel), which perf_event_paranoid <= 2 allows for
+// one's own threads. Counters the kernel or the hypervisor refuses are reported
+// as unavailable; if the group cannot be opened at all, every counter is.
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace ics {
+
+enum PerfCounter { PERF_CYCLES, PERF_INSTRUCTIONS, PERF_CACHE_MISSES, PERF_BRANCH_MISSES, PERF_COUNTERS };
+
+const char *perf_counter_name(int c);
+
+struct PerfSample {
+    std::array<uint64_t, PERF_COUNTERS> value{};
+};
+
+// Sum of per-section counter deltas
+struct PerfTotals {
+    uint64_t sections = 0;
+    std::array<uint64_t, PERF_COUNTERS> sum{};
+
+    void add(const PerfSample &before, const PerfSample &after);
+    double per_section(int c) const { return sections ? (double)sum[c] / sections : 0; }
+};
+
+// Counts the thread that constructs it; read() must be called from that thread
+class PerfGroup {
+public:
+    PerfGroup();
+    ~PerfGroup();
+    PerfGroup(const PerfGroup &) = delete;
+    PerfGroup &operator=(const PerfGroup &) = delete;
+
+    bool available() const { return fds_[PERF_CYCLES] >= 0; }
+    bool available(int c) const { return fds_[c] >= 0; }
+    // Why the group (or the first refused counter) is unavailable
+    const std::string &error() const { return error_; }
+
+    // Current counts; unavailable counters read as 0
+    bool read(PerfSample &s) const;
+
+private:
+    std::array<int, PERF_COUNTERS> fds_;
+    std::array<int, PERF_COUNTERS> slot_;   // position of each counter in the group read, -1 if absent
+    int members_ = 0;
+    std::string error_;
+};
+
+} // namespace ics
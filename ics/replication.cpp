@@ -0,0 +1,83 @@
+#include "ics/replication.h"
+
+#include <cmath>
+
+#include "ics/parallel.h"
+
+using namespace std;
+
+namespace ics {
+
+double t_critical_95(int df) {
+    static const double table[] = {
+        0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df < 1) return 0;
+    if (df <= 30) return table[df];
+    if (df <= 60) return 2.000;
+    if (df <= 120) return 1.980;
+    return 1.960;
+}
+
+Estimate estimate(const vector<double> &samples) {
+    Estimate e;
+    size_t n = samples.size();
+    if (!n) return e;
+    double sum = 0;
+    for (double v : samples) sum += v;
+    e.mean = sum / n;
+    if (n < 2) return e;
+    double ss = 0;
+    for (double v : samples) ss += (v - e.mean) * (v - e.mean);
+    e.ci95 = t_critical_95((int)n - 1) * sqrt(ss / (n - 1) / n);
+    return e;
+}
+
+void ReplicationAccumulator::add(const SimResult &r) {
+    lock_guard<mutex> lg(mtx_);
+    for (Device d : ALL_DEVICES) {
+        DeviceSamples &s = dev_[d];
+        s.throughput.push_back(r.throughput(d));
+        s.p99_ms.push_back(r.devices[d].latency.quantile(0.99) / 1e6);
+        s.drop_rate.push_back(r.drop_rate(d));
+        s.pooled.merge(r.devices[d].latency);
+    }
+    utilization_.push_back(r.duration_ns ? (double)r.busy_ns / r.duration_ns : 0);
+}
+
+ReplicationSummary ReplicationAccumulator::summary() const {
+    lock_guard<mutex> lg(mtx_);
+    ReplicationSummary sum;
+    sum.replications = (int)utilization_.size();
+    for (Device d : ALL_DEVICES) {
+        const DeviceSamples &s = dev_[d];
+        sum.devices[d].throughput = estimate(s.throughput);
+        sum.devices[d].p99_ms = estimate(s.p99_ms);
+        sum.devices[d].drop_rate = estimate(s.drop_rate);
+        sum.devices[d].pooled = s.pooled;
+    }
+    sum.utilization = estimate(utilization_);
+    return sum;
+}
+
+ReplicationSummary replicate(const SimConfig &config, int replications, unsigned threads) {
+    return replicate(vector<SimConfig>{config}, replications, threads)[0];
+}
+
+vector<ReplicationSummary> replicate(const vector<SimConfig> &configs, int replications, unsigned threads) {
+    vector<ReplicationAccumulator> acc(configs.size());
+    parallel_for(configs.size() * replications, threads, [&](size_t i) {
+        size_t p = i / replications;
+        SimConfig c = configs[p];
+        c.seed = configs[p].seed + i % replications;
+        Simulation sim(c);
+        sim.run();
+        acc[p].add(sim.result());
+    });
+    vector<ReplicationSummary> sums;
+    for (const ReplicationAccumulator &a : acc) sums.push_back(a.summary());
+    return sums;
+}
+
+} // namespace ics
@@ -0,0 +1,61 @@
+// Monte Carlo replication: runs independent seeds of one configuration and
+// reports means with 95% confidence intervals. Latency histograms of all
+// replications are merged, so pooled percentiles are exact over every sample.
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <vector>
+
+#include "ics/histogram.h"
+#include "ics/simulation.h"
+
+namespace ics {
+
+struct Estimate {
+    double mean = 0;
+    double ci95 = 0;            // half-width of the 95% confidence interval of the mean
+};
+
+struct DeviceSummary {
+    Estimate throughput;        // interrupts/s
+    Estimate p99_ms;            // per-replication p99 latency
+    Estimate drop_rate;         // dropped / arrivals
+    LatencyHistogram pooled;    // every replication's latency samples
+};
+
+struct ReplicationSummary {
+    int replications = 0;
+    std::array<DeviceSummary, DEVICE_SLOTS> devices{};
+    Estimate utilization;
+};
+
+// Two-sided 95% Student t critical value for df degrees of freedom
+double t_critical_95(int df);
+Estimate estimate(const std::vector<double> &samples);
+
+// Collects replication results; add() may be called from several threads
+class ReplicationAccumulator {
+public:
+    void add(const SimResult &r);
+    ReplicationSummary summary() const;
+
+private:
+    struct DeviceSamples {
+        std::vector<double> throughput, p99_ms, drop_rate;
+        LatencyHistogram pooled;
+    };
+    mutable std::mutex mtx_;
+    std::array<DeviceSamples, DEVICE_SLOTS> dev_{};
+    std::vector<double> utilization_;
+};
+
+// Runs `replications` copies of config with seeds config.seed, config.seed + 1, ...
+ReplicationSummary replicate(const SimConfig &config, int replications, unsigned threads = 0);
+// Same for several configurations at once (e.g. sweep points); every
+// (configuration, replication) pair is one work item, so even a single
+// configuration uses all threads. Summaries are in the order of configs.
+std::vector<ReplicationSummary> replicate(const std::vector<SimConfig> &configs, int replications,
+                                          unsigned threads = 0);
+
+} // namespace ics
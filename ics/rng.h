@@ -0,0 +1,114 @@
+// Random number generation for arrival and service models.
+// Xoshiro256x4 runs four independent xoshiro256** streams in lock step with a
+// structure-of-arrays state, so filling a block is a plain loop over lanes that
+// the compiler vectorizes (AVX2 where available). BlockRng hands the block out
+// one variate at a time. Both are plain values: copying one forks the stream.
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "ics/binio.h"
+
+namespace ics {
+
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+class Xoshiro256x4 {
+public:
+    static const int LANES = 4;
+
+    // Lanes are filled from the splitmix64 sequence starting at seed (the state
+    // advances by the golden-ratio increment), so nearby seeds such as
+    // consecutive replications share no state words
+    explicit Xoshiro256x4(uint64_t seed = 1) {
+        uint64_t x = seed;
+        for (auto &word : s_)
+            for (auto &lane : word) {
+                lane = splitmix64(x);
+                x += 0x9e3779b97f4a7c15ull;
+            }
+    }
+
+    // n must be a multiple of LANES
+    void fill(uint64_t *out, int n) {
+        for (int i = 0; i < n; i += LANES) {
+            for (int l = 0; l < LANES; ++l) {
+                uint64_t r = rotl(s_[1][l] * 5, 7) * 9;
+                uint64_t t = s_[1][l] << 17;
+                s_[2][l] ^= s_[0][l];
+                s_[3][l] ^= s_[1][l];
+                s_[1][l] ^= s_[2][l];
+                s_[0][l] ^= s_[3][l];
+                s_[2][l] ^= t;
+                s_[3][l] = rotl(s_[3][l], 45);
+                out[i + l] = r;
+            }
+        }
+    }
+
+    using State = std::array<std::array<uint64_t, LANES>, 4>;
+    const State &state() const { return s_; }
+    void set_state(const State &s) { s_ = s; }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+    State s_; // s_[word][lane]
+};
+
+class BlockRng {
+public:
+    static const int BLOCK = 64;
+
+    explicit BlockRng(uint64_t seed = 1) : gen_(seed) {}
+
+    uint64_t next() {
+        if (pos_ == BLOCK) {
+            gen_.fill(buf_.data(), BLOCK);
+            pos_ = 0;
+        }
+        return buf_[pos_++];
+    }
+    // [0, 1)
+    double uniform() { return (next() >> 11) * 0x1.0p-53; }
+    // (0, 1], safe for log()
+    double uniform_pos() { return ((next() >> 11) + 1) * 0x1.0p-53; }
+    double exponential(double mean) { return -std::log(uniform_pos()) * mean; }
+    double normal() {
+        // Box-Muller; one of the pair is discarded to keep the state simple
+        return std::sqrt(-2 * std::log(uniform_pos())) * std::cos(6.283185307179586 * uniform());
+    }
+
+    // Generator state plus the unconsumed rest of the block, so a restored
+    // stream continues with exactly the variates the saved one would have produced
+    void save(BinWriter &w) const {
+        for (auto &word : gen_.state())
+            for (uint64_t lane : word) w.u64(lane);
+        w.u32((uint32_t)pos_);
+        for (int i = pos_; i < BLOCK; ++i) w.u64(buf_[i]);
+    }
+    bool load(BinReader &r) {
+        Xoshiro256x4::State s;
+        for (auto &word : s)
+            for (auto &lane : word) lane = r.u64();
+        uint32_t pos = r.u32();
+        if (!r.ok() || pos > (uint32_t)BLOCK) return false;
+        gen_.set_state(s);
+        pos_ = (int)pos;
+        for (int i = pos_; i < BLOCK; ++i) buf_[i] = r.u64();
+        return r.ok();
+    }
+
+private:
+    Xoshiro256x4 gen_;
+    std::array<uint64_t, BLOCK> buf_{};
+    int pos_ = BLOCK;
+};
+
+} // namespace ics
@@ -0,0 +1,312 @@
+#include "ics/scenario.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "ics/control.h"
+#include "ics/spin.h"
+
+using namespace std;
+
+namespace ics {
+
+// Real-time injection sleeps until this close to the deadline, then spins
+static const int64_t SPIN_AHEAD_NS = 200000;
+
+namespace {
+
+struct Command {
+    string verb;
+    Device dev = KEYBOARD;
+    double hz = 0;
+    SchedulingPolicy policy = SchedulingPolicy::PRIORITY;
+    int tpr = 0;
+};
+
+bool parse_command(const string &text, Command &c, string &error) {
+    stringstream ss(text);
+    string arg;
+    auto fail = [&](const string &what) {
+        error = what;
+        return false;
+    };
+    ss >> c.verb;
+    if (c.verb == "mask" || c.verb == "unmask") {
+        if (!(ss >> arg) || !parse_device_letter(arg, c.dev)) return fail(c.verb + " expects k|m|p");
+    } else if (c.verb == "set-rate") {
+        string hz;
+        if (!(ss >> arg >> hz) || !parse_device_letter(arg, c.dev)) return fail("set-rate expects k|m|p HZ");
+        char *end = nullptr;
+        c.hz = strtod(hz.c_str(), &end);
+        if (*end || !(c.hz > 0)) return fail("set-rate: rate must be a positive number");
+    } else if (c.verb == "set-policy") {
+        if (!(ss >> arg) || !parse_policy(arg, c.policy)) return fail("set-policy expects priority|fifo|rr");
+    } else if (c.verb == "tpr") {
+        if (!(ss >> arg) || !parse_tpr(arg, c.tpr)) return fail("tpr expects a level 0-" + to_string(MAX_TPR));
+    } else {
+        return fail("unknown command '" + c.verb + "' (mask, unmask, set-rate, set-policy, tpr)");
+    }
+    return true;
+}
+
+bool parse_metric(const string &s, ScenarioMetric &m) {
+    if (s == "p50") m = ScenarioMetric::P50;
+    else if (s == "p90") m = ScenarioMetric::P90;
+    else if (s == "p99") m = ScenarioMetric::P99;
+    else if (s == "p99.9" || s == "p999") m = ScenarioMetric::P999;
+    else if (s == "max") m = ScenarioMetric::MAX;
+    else if (s == "mean") m = ScenarioMetric::MEAN;
+    else if (s == "throughput") m = ScenarioMetric::THROUGHPUT;
+    else if (s == "drop_rate") m = ScenarioMetric::DROP_RATE;
+    else if (s == "dispatched") m = ScenarioMetric::DISPATCHED;
+    else return false;
+    return true;
+}
+
+bool is_latency(ScenarioMetric m) {
+    return m <= ScenarioMetric::MEAN;
+}
+
+string format_latency(double ns) {
+    char buf[32];
+    if (ns >= 1e9) snprintf(buf, sizeof(buf), "%.3gs", ns / 1e9);
+    else if (ns >= 1e6) snprintf(buf, sizeof(buf), "%.3gms", ns / 1e6);
+    else if (ns >= 1e3) snprintf(buf, sizeof(buf), "%.3gus", ns / 1e3);
+    else snprintf(buf, sizeof(buf), "%.0fns", ns);
+    return buf;
+}
+
+} // namespace
+
+bool parse_duration_ns(const string &text, int64_t &ns) {
+    char *end = nullptr;
+    double v = strtod(text.c_str(), &end);
+    if (end == text.c_str() || !(v >= 0)) return false;
+    string unit = end;
+    double scale;
+    if (unit.empty() || unit == "s") scale = 1e9;
+    else if (unit == "ms") scale = 1e6;
+    else if (unit == "us") scale = 1e3;
+    else if (unit == "ns") scale = 1;
+    else return false;
+    ns = (int64_t)llround(v * scale);
+    return true;
+}
+
+bool Scenario::parse(istream &in, Scenario &s, string &error) {
+    s = Scenario();
+    string line;
+    int n = 0;
+    bool has_duration = false;
+    auto fail = [&](const string &what) {
+        error = "line " + to_string(n) + ": " + what;
+        return false;
+    };
+    while (getline(in, line)) {
+        ++n;
+        size_t hash = line.find('#');
+        if (hash != string::npos) line.erase(hash);
+        stringstream ss(line);
+        string key;
+        if (!(ss >> key)) continue;
+        string a, b, rest;
+        Device dev;
+        if (key == "duration") {
+            int64_t ns;
+            if (!(ss >> a) || !parse_duration_ns(a, ns) || ns <= 0) return fail("duration expects a positive time");
+            s.duration_s = ns / 1e9;
+            has_duration = true;
+        } else if (key == "arrival" || key == "service") {
+            if (!(ss >> a >> b) || !parse_device_letter(a, dev)) return fail(key + " expects k|m|p SPEC");
+            string spec_error;
+            bool ok = key == "arrival" ? ArrivalSpec::parse(b, s.arrival[dev], spec_error)
+                                       : ServiceSpec::parse(b, s.service[dev], spec_error);
+            if (!ok) return fail(key + ": " + spec_error);
+            (key == "arrival" ? s.has_arrival : s.has_service)[dev] = true;
+        } else if (key == "policy") {
+            if (!(ss >> a) || !parse_policy(a, s.policy)) return fail("policy expects priority|fifo|rr");
+            s.has_policy = true;
+        } else if (key == "at") {
+            int64_t ns;
+            if (!(ss >> a) || !parse_duration_ns(a, ns)) return fail("at expects a time, e.g. 'at 5s mask p'");
+            getline(ss, rest);
+            Command c;
+            string command_error;
+            if (!parse_command(rest, c, command_error)) return fail(command_error);
+            rest.erase(0, rest.find_first_not_of(" \t"));
+            s.events.push_back({ns, rest, n});
+        } else if (key == "expect") {
+            Expectation e;
+            string op, value;
+            if (!(ss >> a >> b >> op >> value) || !parse_device_letter(a, e.dev))
+                return fail("expect needs: expect k|m|p METRIC OP VALUE");
+            if (!parse_metric(b, e.metric)) return fail("unknown metric '" + b + "'");
+            if (op != "<" && op != "<=" && op != ">" && op != ">=") return fail("operator must be <, <=, > or >=");
+            if (is_latency(e.metric)) {
+                int64_t ns;
+                if (!parse_duration_ns(value, ns)) return fail("latency bound expects a time, e.g. 50ms");
+                e.bound = (double)ns;
+            } else {
+                char *end = nullptr;
+                e.bound = strtod(value.c_str(), &end);
+                if (*end || end == value.c_str()) return fail("bound must be a number");
+            }
+            e.op = op;
+            e.text = "expect " + a + " " + b + " " + op + " " + value;
+            e.line = n;
+            s.expectations.push_back(e);
+        } else {
+            return fail("unknown directive '" + key + "'");
+        }
+    }
+    for (const ScenarioEvent &e : s.events)
+        if (e.at_ns > (int64_t)llround(s.duration_s * 1e9)) {
+            n = e.line;
+            return fail(has_duration ? "command after the end of the scenario" : "command after the default 10s duration");
+        }
+    stable_sort(s.events.begin(), s.events.end(),
+                [](const ScenarioEvent &x, const ScenarioEvent &y) { return x.at_ns < y.at_ns; });
+    return true;
+}
+
+bool Scenario::load(const string &path, Scenario &s, string &error) {
+    ifstream in(path);
+    if (!in) {
+        error = path + ": cannot open";
+        return false;
+    }
+    if (!parse(in, s, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+double scenario_measure(const DeviceStats &s, double seconds, ScenarioMetric metric) {
+    switch (metric) {
+        case ScenarioMetric::P50: return (double)s.latency.quantile(0.5);
+        case ScenarioMetric::P90: return (double)s.latency.quantile(0.9);
+        case ScenarioMetric::P99: return (double)s.latency.quantile(0.99);
+        case ScenarioMetric::P999: return (double)s.latency.quantile(0.999);
+        case ScenarioMetric::MAX: return (double)s.latency.max();
+        case ScenarioMetric::MEAN: return s.latency.mean();
+        case ScenarioMetric::THROUGHPUT: return seconds > 0 ? s.dispatched / seconds : 0;
+        case ScenarioMetric::DROP_RATE: return s.arrivals ? (double)s.dropped / s.arrivals : 0;
+        case ScenarioMetric::DISPATCHED: return (double)s.dispatched;
+    }
+    return 0;
+}
+
+vector<ExpectationResult> check_expectations(const Scenario &s, const array<DeviceStats, DEVICE_SLOTS> &stats,
+                                             double seconds) {
+    vector<ExpectationResult> out;
+    for (const Expectation &e : s.expectations) {
+        double v = scenario_measure(stats[e.dev], seconds, e.metric);
+        bool ok = e.op == "<" ? v < e.bound : e.op == "<=" ? v <= e.bound : e.op == ">" ? v > e.bound : v >= e.bound;
+        out.push_back({e, v, ok});
+    }
+    return out;
+}
+
+string format_expectation(const ExpectationResult &r) {
+    string actual;
+    if (is_latency(r.expectation.metric)) {
+        actual = format_latency(r.actual);
+    } else {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.6g", r.actual);
+        actual = buf;
+    }
+    return r.expectation.text + ": actual " + actual + (r.ok ? " ok" : " FAILED");
+}
+
+bool run_scenario_virtual(const Scenario &s, SimConfig config, SimResult &result, string &error) {
+    config.duration_s = s.duration_s;
+    if (s.has_policy) config.policy = s.policy;
+    for (Device d : ALL_DEVICES) {
+        if (s.has_arrival[d]) config.devices[d].arrival = s.arrival[d];
+        if (s.has_service[d]) config.devices[d].service = s.service[d];
+    }
+    Simulation sim(config);
+    bool ok = run_scenario_virtual(s, sim, false, error);
+    result = sim.result();
+    return ok;
+}
+
+bool run_scenario_virtual(const Scenario &s, Simulation &sim, bool continuation, string &error) {
+    int64_t t0 = sim.now();
+    if (continuation) {
+        // settings take effect now rather than at construction
+        if (s.has_policy) sim.set_policy(s.policy);
+        for (Device d : ALL_DEVICES) {
+            if (s.has_arrival[d]) sim.set_arrival(d, s.arrival[d]);
+            if (s.has_service[d]) sim.set_service(d, s.service[d]);
+        }
+    }
+    sim.set_end(t0 + (int64_t)llround(s.duration_s * 1e9));
+    for (const ScenarioEvent &e : s.events) {
+        sim.run_until(t0 + e.at_ns);
+        Command c;
+        bool ok = parse_command(e.command, c, error); // already checked by Scenario::load
+        if (!ok) {
+            error = "'" + e.command + "': " + error;
+            return false;
+        }
+        if (c.verb == "mask" || c.verb == "unmask") {
+            sim.set_mask(c.dev, c.verb == "mask");
+        } else if (c.verb == "set-rate") {
+            ArrivalSpec spec = sim.config().devices[c.dev].arrival;
+            spec.rate_hz = c.hz;
+            sim.set_arrival(c.dev, spec);
+        } else if (c.verb == "set-policy") {
+            sim.set_policy(c.policy);
+        } else if (c.verb == "tpr" && !sim.set_tpr(c.tpr)) {
+            error = "'" + e.command + "': level out of range";
+            return false;
+        }
+    }
+    sim.run();
+    return true;
+}
+
+void run_scenario_realtime(const Scenario &s, InterruptController &ic,
+                           const function<void(const ScenarioEvent &, const string &, int64_t)> &on_event,
+                           const atomic<bool> *cancel) {
+    int64_t start = steady_ns();
+    auto wait_until = [&](int64_t deadline) {
+        // sleep in slices so cancel is noticed, then spin the last stretch
+        for (;;) {
+            if (cancel && *cancel) return false;
+            int64_t left = deadline - SPIN_AHEAD_NS - steady_ns();
+            if (left <= 0) break;
+            this_thread::sleep_for(chrono::nanoseconds(min<int64_t>(left, 100000000)));
+        }
+        spin_until(deadline);
+        return true;
+    };
+    for (const ScenarioEvent &e : s.events) {
+        if (!wait_until(start + e.at_ns)) return;
+        int64_t late = steady_ns() - (start + e.at_ns);
+        bool exit = false;
+        string reply = execute_command(ic, e.command, exit);
+        if (on_event) on_event(e, reply, late);
+    }
+    wait_until(start + (int64_t)llround(s.duration_s * 1e9));
+}
+
+array<DeviceStats, DEVICE_SLOTS> controller_stats(const InterruptController &ic) {
+    MetricsSnapshot m = ic.metrics();
+    array<DeviceStats, DEVICE_SLOTS> stats{};
+    for (Device d : ALL_DEVICES) {
+        stats[d].arrivals = m.devices[d].arrivals;
+        stats[d].dispatched = m.devices[d].dispatched;
+        stats[d].latency = ic.latency(d);
+    }
+    return stats;
+}
+
+} // namespace ics
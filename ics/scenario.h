@@ -0,0 +1,107 @@
+// Scenario files: time-stamped commands and latency expectations, e.g.
+//   # printer masked through a keyboard storm
+//   duration 20s
+//   arrival k poisson:rate=5
+//   service p exp:ms=300
+//   policy priority
+//   at 5s  mask p
+//   at 10s set-rate k 500
+//   at 12s unmask p
+//   at 12s set-rate k 5
+//   expect k p99 < 50ms
+//   expect p max <= 3s
+//   expect k throughput >= 4
+// Commands after "at" are control-protocol commands (ics/control.h: mask, unmask,
+// set-rate, set-policy, tpr), so one file drives both the real-time controller and the
+// virtual-time Simulation. Times and latency bounds take ns, us, ms or s (a plain
+// number is seconds). Metrics: p50 p90 p99 p99.9 max mean (latency, raise to ISR
+// start), throughput (dispatches/s), drop_rate (fraction), dispatched (count).
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "ics/arrival.h"
+#include "ics/interrupt_controller.h"
+#include "ics/service.h"
+#include "ics/simulation.h"
+#include "ics/types.h"
+
+namespace ics {
+
+struct ScenarioEvent {
+    int64_t at_ns;
+    std::string command;
+    int line;
+};
+
+enum class ScenarioMetric { P50, P90, P99, P999, MAX, MEAN, THROUGHPUT, DROP_RATE, DISPATCHED };
+
+struct Expectation {
+    Device dev;
+    ScenarioMetric metric;
+    std::string op;             // <, <=, >, >=
+    double bound;               // latency metrics in ns
+    std::string text;           // as written, for reports
+    int line;
+};
+
+struct Scenario {
+    double duration_s = 10;
+    std::array<bool, DEVICE_SLOTS> has_arrival{}, has_service{};
+    std::array<ArrivalSpec, DEVICE_SLOTS> arrival{};
+    std::array<ServiceSpec, DEVICE_SLOTS> service{};
+    bool has_policy = false;
+    SchedulingPolicy policy = SchedulingPolicy::PRIORITY;
+    std::vector<ScenarioEvent> events;      // by time; file order among equal times
+    std::vector<Expectation> expectations;
+
+    // Returns false and fills error ("line N: ...") on bad input
+    static bool parse(std::istream &in, Scenario &s, std::string &error);
+    static bool load(const std::string &path, Scenario &s, std::string &error);
+};
+
+// "5s", "250ms", "40us", "100ns", "1.5" (seconds)
+bool parse_duration_ns(const std::string &text, int64_t &ns);
+
+// Value of metric for one device over a run of the given length
+double scenario_measure(const DeviceStats &s, double seconds, ScenarioMetric metric);
+
+struct ExpectationResult {
+    Expectation expectation;
+    double actual;
+    bool ok;
+};
+
+std::vector<ExpectationResult> check_expectations(const Scenario &s, const std::array<DeviceStats, DEVICE_SLOTS> &stats,
+                                                  double seconds);
+// "expect k p99 < 50ms: actual 12.3ms ok"
+std::string format_expectation(const ExpectationResult &r);
+
+// Virtual time: applies the scenario's settings to config, runs a Simulation to the
+// scenario's duration and injects each command at its exact virtual time.
+// Returns false, with the run stopped at that command, if the Simulation rejects
+// one (possible only for scenarios built without Scenario::load's checks).
+bool run_scenario_virtual(const Scenario &s, SimConfig config, SimResult &result, std::string &error);
+// Same, on an existing Simulation: the scenario's times count from sim.now() and the
+// run is extended by its duration. Stats accumulate on top of what sim already holds.
+// With continuation (a restored or forked run) the scenario's settings are applied
+// at sim.now(); without it sim must have been constructed with them already.
+bool run_scenario_virtual(const Scenario &s, Simulation &sim, bool continuation, std::string &error);
+
+// Real time: injects each command into a started controller at its offset from the
+// call (sleep, then spin the last stretch for sub-millisecond accuracy) and returns
+// once the duration has passed or *cancel is set. on_event sees each command's
+// reply and how late it was applied.
+void run_scenario_realtime(const Scenario &s, InterruptController &ic,
+                           const std::function<void(const ScenarioEvent &, const std::string &reply, int64_t late_ns)> &on_event,
+                           const std::atomic<bool> *cancel = nullptr);
+
+// Measurements of a real-time run, for check_expectations
+std::array<DeviceStats, DEVICE_SLOTS> controller_stats(const InterruptController &ic);
+
+} // namespace ics
@@ -0,0 +1,52 @@
+// Single-writer seqlock: readers copy a consistent snapshot without blocking
+// the writer or each other. The payload is kept as relaxed atomic words, so
+// concurrent copies are well defined (and clean under ThreadSanitizer); the
+// sequence counter tells readers whether the words they copied belong together.
+// T must be trivially copyable. Writers must be serialized by the caller.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ics {
+
+template <class T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock payload must be trivially copyable");
+    static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+    Seqlock() { store(T{}); }
+
+    void store(const T &v) {
+        uint64_t buf[WORDS] = {};
+        std::memcpy(buf, &v, sizeof(T));
+        unsigned s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed); // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) words_[i].store(buf[i], std::memory_order_relaxed);
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+    T load() const {
+        uint64_t buf[WORDS];
+        for (;;) {
+            unsigned s1 = seq_.load(std::memory_order_acquire);
+            if (s1 & 1) continue;
+            for (size_t i = 0; i < WORDS; ++i) buf[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == s1) break;
+        }
+        T v;
+        std::memcpy(&v, buf, sizeof(T));
+        return v;
+    }
+
+private:
+    std::atomic<unsigned> seq_{0};
+    std::atomic<uint64_t> words_[WORDS];
+};
+
+} // namespace ics
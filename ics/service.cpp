@@ -0,0 +1,132 @@
+#include "ics/service.h"
+
+#include <cmath>
+#include <sstream>
+
+#include "ics/spec_params.h"
+
+using namespace std;
+
+namespace ics {
+
+ServiceSpec ServiceSpec::constant_ms(double ms) {
+    ServiceSpec s;
+    s.mean_ms = ms;
+    return s;
+}
+
+bool ServiceSpec::parse(const string &text, ServiceSpec &spec, string &error) {
+    double prev_mean = spec.mean_ms;
+    spec = ServiceSpec();
+    spec.mean_ms = prev_mean;
+    string kind;
+    vector<SpecParam> params;
+    if (!split_spec(text, kind, params, error)) return false;
+    if (kind == "const" || kind == "constant") spec.kind = ServiceKind::CONSTANT;
+    else if (kind == "exp" || kind == "exponential") spec.kind = ServiceKind::EXPONENTIAL;
+    else if (kind == "lognormal") spec.kind = ServiceKind::LOGNORMAL;
+    else if (kind == "empirical") spec.kind = ServiceKind::EMPIRICAL;
+    else {
+        error = "unknown service model '" + kind + "'";
+        return false;
+    }
+
+    double ms = -1;
+    string file;
+    for (const SpecParam &p : params) {
+        if (p.key == "file") {
+            file = p.value;
+            continue;
+        }
+        if (!p.is_number) {
+            error = "bad value for " + p.key + ": '" + p.value + "'";
+            return false;
+        }
+        if (p.key == "ms") ms = p.number;
+        else if (p.key == "sigma") spec.sigma = p.number;
+        else {
+            error = "unknown parameter '" + p.key + "' for " + kind;
+            return false;
+        }
+    }
+
+    if (spec.kind == ServiceKind::EMPIRICAL) {
+        auto samples = make_shared<vector<int64_t>>();
+        if (!load_ns_samples(file, *samples, error)) return false;
+        double total = 0;
+        for (int64_t v : *samples) total += v;
+        spec.samples = samples;
+        spec.samples_mean_ms = total / samples->size() / 1e6;
+        spec.mean_ms = spec.samples_mean_ms;
+    }
+    if (ms >= 0) spec.mean_ms = ms;
+    return true;
+}
+
+string ServiceSpec::describe() const {
+    stringstream ss;
+    switch (kind) {
+        case ServiceKind::CONSTANT: ss << "const:ms=" << mean_ms; break;
+        case ServiceKind::EXPONENTIAL: ss << "exp:ms=" << mean_ms; break;
+        case ServiceKind::LOGNORMAL: ss << "lognormal:ms=" << mean_ms << ",sigma=" << sigma; break;
+        case ServiceKind::EMPIRICAL: ss << "empirical:ms=" << mean_ms; break;
+    }
+    return ss.str();
+}
+
+ServiceProcess::ServiceProcess(const ServiceSpec &spec, uint64_t seed) : spec_(spec), rng_(seed) {}
+
+int64_t ServiceProcess::next_ns() {
+    double mean_ns = spec_.mean_ms * 1e6;
+    double v = mean_ns;
+    switch (spec_.kind) {
+        case ServiceKind::CONSTANT:
+            break;
+        case ServiceKind::EXPONENTIAL:
+            v = rng_.exponential(mean_ns);
+            break;
+        case ServiceKind::LOGNORMAL:
+            // mu chosen so that E[X] = mean: mu = ln(mean) - sigma^2 / 2
+            v = exp(log(mean_ns) - spec_.sigma * spec_.sigma / 2 + spec_.sigma * rng_.normal());
+            break;
+        case ServiceKind::EMPIRICAL: {
+            const vector<int64_t> &s = *spec_.samples;
+            v = s[rng_.next() % s.size()] * (spec_.mean_ms / spec_.samples_mean_ms);
+            break;
+        }
+    }
+    return v > 0 ? (int64_t)llround(v) : 0;
+}
+
+void ServiceSpec::save(BinWriter &w) const {
+    w.u8((uint8_t)kind);
+    w.f64(mean_ms);
+    w.f64(sigma);
+    w.u8(samples ? 1 : 0);
+    if (samples) w.i64s(*samples);
+    w.f64(samples_mean_ms);
+}
+
+bool ServiceSpec::load(BinReader &r) {
+    uint8_t k = r.u8();
+    if (k > (uint8_t)ServiceKind::EMPIRICAL) r.fail();
+    kind = (ServiceKind)k;
+    mean_ms = r.f64();
+    sigma = r.f64();
+    samples.reset();
+    if (r.u8()) samples = make_shared<const vector<int64_t>>(r.i64s());
+    samples_mean_ms = r.f64();
+    if (kind == ServiceKind::EMPIRICAL && (!samples || samples->empty())) r.fail();
+    return r.ok();
+}
+
+void ServiceProcess::save(BinWriter &w) const {
+    spec_.save(w);
+    rng_.save(w);
+}
+
+bool ServiceProcess::load(BinReader &r) {
+    return spec_.load(r) && rng_.load(r);
+}
+
+} // namespace ics
@@ -0,0 +1,55 @@
+// ISR service-time models: how long one ISR takes.
+// mean_ms is always the mean service time, whatever the model, so --isr sweeps
+// mean the same thing for every kind. Samples are in ns.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ics/rng.h"
+
+namespace ics {
+
+enum class ServiceKind {
+    CONSTANT,
+    EXPONENTIAL,
+    LOGNORMAL,  // sigma is the shape (std dev of the underlying normal)
+    EMPIRICAL   // recorded service times resampled at random, scaled to mean_ms
+};
+
+struct ServiceSpec {
+    ServiceKind kind = ServiceKind::CONSTANT;
+    double mean_ms = 0;
+    double sigma = 0.5;
+    std::shared_ptr<const std::vector<int64_t>> samples; // EMPIRICAL, ns
+    double samples_mean_ms = 0;
+
+    // "kind[:key=value,...]", e.g. const:ms=300, exp:ms=300, lognormal:ms=300,sigma=1,
+    // empirical:file=isr_times.txt[,ms=M]. Files hold one service time in ns per line.
+    // Without ms= (or samples) the spec keeps its current mean.
+    static bool parse(const std::string &text, ServiceSpec &spec, std::string &error);
+    static ServiceSpec constant_ms(double ms);
+    std::string describe() const;
+
+    // Checkpoint encoding, samples included
+    void save(BinWriter &w) const;
+    bool load(BinReader &r);
+};
+
+class ServiceProcess {
+public:
+    ServiceProcess(const ServiceSpec &spec, uint64_t seed);
+    int64_t next_ns();
+    const ServiceSpec &spec() const { return spec_; }
+
+    void save(BinWriter &w) const;
+    bool load(BinReader &r);
+
+private:
+    ServiceSpec spec_;
+    BlockRng rng_;
+};
+
+} // namespace ics
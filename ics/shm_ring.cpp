@@ -0,0 +1,192 @@
+#include "ics/shm_ring.h"
+
+#include <chrono>
+#include <vector>
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "ics/interrupt_controller.h"
+
+using namespace std;
+
+namespace ics {
+
+static size_t ring_bytes(size_t capacity) {
+    return offsetof(ShmRingHeader, slots) + capacity * sizeof(ShmSlot);
+}
+
+// Shared (not FUTEX_PRIVATE) operations: waiter and waker are in different processes
+static void futex_wait(atomic<uint32_t> *word, uint32_t expected, int timeout_ms) {
+    timespec ts{timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000};
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+static void futex_wake(atomic<uint32_t> *word) {
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+ShmRing::~ShmRing() {
+    if (hdr_) munmap(hdr_, bytes_);
+    if (owner_) shm_unlink(name_.c_str());
+}
+
+bool ShmRing::map(int fd, size_t bytes, string &error) {
+    void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        error = name_ + ": mmap: " + strerror(errno);
+        return false;
+    }
+    hdr_ = (ShmRingHeader *)p;
+    bytes_ = bytes;
+    return true;
+}
+
+bool ShmRing::create(const string &name, size_t capacity, string &error) {
+    size_t n = 2;
+    while (n < capacity) n <<= 1;
+    name_ = name;
+    shm_unlink(name.c_str()); // left behind by an earlier run
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, ring_bytes(n)) != 0) {
+        error = name + ": " + strerror(errno);
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    owner_ = true;
+    if (!map(fd, ring_bytes(n), error)) return false;
+    // fresh pages are zero; the atomics only need their initial values stored
+    hdr_->capacity = n;
+    hdr_->head.store(0, memory_order_relaxed);
+    hdr_->tail.store(0, memory_order_relaxed);
+    hdr_->sleeping.store(0, memory_order_relaxed);
+    hdr_->dropped.store(0, memory_order_relaxed);
+    for (size_t i = 0; i < n; ++i) hdr_->slots[i].seq.store(i, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    __atomic_store_n(&hdr_->magic, ShmRingHeader::MAGIC, __ATOMIC_RELEASE); // attachers check this last
+    return true;
+}
+
+bool ShmRing::attach(const string &name, string &error) {
+    name_ = name;
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        error = name + ": " + strerror(errno) + " (is the controller running with --shm-ingress?)";
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    if ((size_t)st.st_size < ring_bytes(2)) {
+        close(fd);
+        error = name + ": not an interrupt ring";
+        return false;
+    }
+    if (!map(fd, (size_t)st.st_size, error)) return false;
+    if (__atomic_load_n(&hdr_->magic, __ATOMIC_ACQUIRE) != ShmRingHeader::MAGIC ||
+        ring_bytes(hdr_->capacity) > bytes_) {
+        error = name + ": not an interrupt ring";
+        return false;
+    }
+    return true;
+}
+
+bool ShmRing::push(Device dev, int64_t t_ns) {
+    uint64_t mask = hdr_->capacity - 1;
+    uint64_t pos = hdr_->head.load(memory_order_relaxed);
+    ShmSlot *slot;
+    for (;;) {
+        slot = &hdr_->slots[pos & mask];
+        uint64_t seq = slot->seq.load(memory_order_acquire);
+        if (seq == pos) {
+            if (hdr_->head.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+        } else if (seq < pos) {
+            hdr_->dropped.fetch_add(1, memory_order_relaxed); // still holds an event from a lap ago: full
+            return false;
+        } else {
+            pos = hdr_->head.load(memory_order_relaxed);      // another producer took it
+        }
+    }
+    slot->t_ns = t_ns;
+    slot->dev = dev;
+    slot->seq.store(pos + 1, memory_order_release);
+    // seq_cst pairs with the consumer's store to sleeping followed by its emptiness re-check
+    atomic_thread_fence(memory_order_seq_cst);
+    if (hdr_->sleeping.load(memory_order_relaxed)) wake_consumer();
+    return true;
+}
+
+void ShmRing::wake_consumer() {
+    if (hdr_->sleeping.exchange(0)) futex_wake(&hdr_->sleeping);
+}
+
+size_t ShmRing::pop_batch(InterruptEvent *out, size_t max, int timeout_ms) {
+    uint64_t mask = hdr_->capacity - 1;
+    uint64_t pos = hdr_->tail.load(memory_order_relaxed);
+    auto ready = [&] { return hdr_->slots[pos & mask].seq.load(memory_order_acquire) == pos + 1; };
+    if (!ready() && timeout_ms > 0) {
+        hdr_->sleeping.store(1);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (!ready()) futex_wait(&hdr_->sleeping, 1, timeout_ms);
+        hdr_->sleeping.store(0, memory_order_relaxed);
+    }
+    size_t n = 0;
+    while (n < max && ready()) {
+        ShmSlot &s = hdr_->slots[pos & mask];
+        if (s.dev >= PRINTER && s.dev <= KEYBOARD) {
+            out[n].dev = (Device)s.dev;
+            out[n].seq = 0;
+            out[n].timestamp = chrono::steady_clock::time_point(chrono::nanoseconds(s.t_ns));
+            ++n;
+        }
+        s.seq.store(pos + hdr_->capacity, memory_order_release); // free for the next lap
+        ++pos;
+    }
+    hdr_->tail.store(pos, memory_order_relaxed);
+    return n;
+}
+
+// Batch size per controller lock acquisition, and how long the pump sleeps when idle
+static const size_t PUMP_BATCH = 1024;
+static const int PUMP_WAIT_MS = 100;
+// Past this many pending interrupts the pump stops draining, so a flood backs up
+// into the ring (where producers see it as full) instead of into the controller's queue
+static const uint64_t PUMP_MAX_BACKLOG = 1 << 16;
+
+bool ShmIngress::start(const string &name, size_t capacity, InterruptController &ic, string &error) {
+    if (!ring_.create(name, capacity, error)) return false;
+    running_ = true;
+    thread_ = thread(&ShmIngress::pump, this, &ic);
+    return true;
+}
+
+void ShmIngress::stop() {
+    if (!running_) return;
+    running_ = false;
+    thread_.join();
+}
+
+void ShmIngress::pump(InterruptController *ic) {
+    vector<InterruptEvent> batch(PUMP_BATCH);
+    while (running_.load(memory_order_relaxed)) {
+        if (ic->metrics().queue_depth >= PUMP_MAX_BACKLOG) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            continue;
+        }
+        size_t n = ring_.pop_batch(batch.data(), batch.size(), PUMP_WAIT_MS);
+        if (!n) continue;
+        ic->raise_batch(batch.data(), n);
+        received_.fetch_add(n, memory_order_relaxed);
+    }
+}
+
+} // namespace ics
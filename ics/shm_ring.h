@@ -0,0 +1,98 @@
+// Shared-memory interrupt ingress: a bounded multi-producer/single-consumer ring
+// in a POSIX shared-memory object, so separate generator processes can raise
+// interrupts with a few atomic operations and no syscalls or serialization.
+//
+// The ring is Vyukov's bounded MPMC queue restricted to one consumer: producers
+// claim a slot by CAS on the head, write it, then publish it through the slot's
+// sequence number. A consumer with nothing to do sleeps on a futex in the shared
+// header; producers only make the wake syscall when it is actually asleep.
+// Timestamps are CLOCK_MONOTONIC ns (std::chrono::steady_clock on Linux), which
+// all processes on the host share, so queueing latency is measured end to end.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "ics/types.h"
+
+namespace ics {
+
+struct ShmSlot {
+    std::atomic<uint64_t> seq;   // == position: free; == position + 1: holds an event
+    int64_t t_ns;                // raise time, steady clock
+    int32_t dev;
+    int32_t reserved;
+};
+
+struct ShmRingHeader {
+    static const uint64_t MAGIC = 0x31474e4952534349ULL; // "ICSRING1"
+    uint64_t magic;
+    uint64_t capacity;                           // power of two
+    alignas(64) std::atomic<uint64_t> head;      // next position producers claim
+    alignas(64) std::atomic<uint64_t> tail;      // next position the consumer reads
+    alignas(64) std::atomic<uint32_t> sleeping;  // futex word: 1 while the consumer waits
+    std::atomic<uint64_t> dropped;               // pushes that found the ring full
+    alignas(64) ShmSlot slots[1];                // capacity slots follow
+};
+
+// Maps a ring; the consumer creates it, producers attach by name
+class ShmRing {
+public:
+    ShmRing() = default;
+    ~ShmRing();
+    ShmRing(const ShmRing &) = delete;
+    ShmRing &operator=(const ShmRing &) = delete;
+
+    // name is a shm_open name such as "/ics_ingress"; an existing object is replaced
+    bool create(const std::string &name, size_t capacity, std::string &error);
+    bool attach(const std::string &name, std::string &error);
+
+    // producer side, any number of threads/processes; false (and counted) when full
+    bool push(Device dev, int64_t t_ns);
+
+    // consumer side: pops up to max events, waiting up to timeout_ms for the first.
+    // Events get seq 0; events naming no known device are discarded.
+    size_t pop_batch(InterruptEvent *out, size_t max, int timeout_ms);
+
+    uint64_t dropped() const { return hdr_ ? hdr_->dropped.load(std::memory_order_relaxed) : 0; }
+    size_t capacity() const { return hdr_ ? (size_t)hdr_->capacity : 0; }
+    const std::string &name() const { return name_; }
+
+private:
+    bool map(int fd, size_t bytes, std::string &error);
+    void wake_consumer();
+
+    ShmRingHeader *hdr_ = nullptr;
+    size_t bytes_ = 0;
+    std::string name_;
+    bool owner_ = false;  // created it, so unlink on destruction
+};
+
+class InterruptController;
+
+// Creates a ring and feeds everything pushed into it to a controller, in batches,
+// through InterruptController::raise_batch - the same queue device threads use.
+// While the controller is far behind, events are left in the ring (backpressure).
+class ShmIngress {
+public:
+    ShmIngress() = default;
+    ~ShmIngress() { stop(); }
+
+    bool start(const std::string &name, size_t capacity, InterruptController &ic, std::string &error);
+    void stop();
+    uint64_t received() const { return received_; }
+    uint64_t dropped() const { return ring_.dropped(); }
+
+private:
+    void pump(InterruptController *ic);
+
+    ShmRing ring_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> received_{0};
+    std::thread thread_;
+};
+
+} // namespace ics
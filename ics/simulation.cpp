@@ -0,0 +1,233 @@
+#include "ics/simulation.h"
+
+#include <climits>
+#include <cmath>
+
+#include "ics/interrupt_controller.h"
+
+using namespace std;
+
+namespace ics {
+
+static const int64_t NEVER = INT64_MAX;
+
+SimConfig SimConfig::defaults() {
+    SimConfig c;
+    // same as the console simulator: 0.8-2s, 1-3s, 1.5-4s
+    c.devices[KEYBOARD] = {ArrivalSpec::uniform_ms(800, 2000), ServiceSpec::constant_ms(300), false, 0};
+    c.devices[MOUSE] = {ArrivalSpec::uniform_ms(1000, 3000), ServiceSpec::constant_ms(500), false, 0};
+    c.devices[PRINTER] = {ArrivalSpec::uniform_ms(1500, 4000), ServiceSpec::constant_ms(800), false, 0};
+    return c;
+}
+
+void DeviceStats::merge(const DeviceStats &o) {
+    arrivals += o.arrivals;
+    dispatched += o.dispatched;
+    dropped += o.dropped;
+    latency.merge(o.latency);
+}
+
+void DeviceStats::save(BinWriter &w) const {
+    w.u64(arrivals);
+    w.u64(dispatched);
+    w.u64(dropped);
+    latency.save(w);
+}
+
+bool DeviceStats::load(BinReader &r) {
+    arrivals = r.u64();
+    dispatched = r.u64();
+    dropped = r.u64();
+    return latency.load(r);
+}
+
+Simulation::Simulation(const SimConfig &config)
+    : config_(config), end_ns_((int64_t)llround(config.duration_s * 1e9)) {
+    for (int d = 0; d < DEVICE_SLOTS; ++d) {
+        uint64_t stream = config_.seed * DEVICE_SLOTS + d;
+        dev_.push_back({{}, 0, ArrivalProcess(config_.devices[d].arrival, splitmix64(stream)),
+                        ServiceProcess(config_.devices[d].service, splitmix64(~stream)), {}});
+    }
+    for (Device d : ALL_DEVICES) {
+        DeviceState &s = dev_[d];
+        s.next_arrival = config_.devices[d].arrival.rate_hz > 0 ? s.arrivals.next_gap_ns() : NEVER;
+    }
+}
+
+void Simulation::set_mask(Device d, bool masked) {
+    config_.devices[d].masked = masked;
+    if (!masked && !busy_) dispatch();
+}
+
+bool Simulation::set_tpr(int level) {
+    if (level < 0 || level > MAX_TPR) return false;
+    config_.tpr = level;
+    if (!busy_) dispatch();
+    return true;
+}
+
+void Simulation::set_arrival(Device d, const ArrivalSpec &spec) {
+    config_.devices[d].arrival = spec;
+    DeviceState &s = dev_[d];
+    s.arrivals = ArrivalProcess(spec, splitmix64(config_.seed * DEVICE_SLOTS + d + (++reseeds_ << 32)));
+    s.next_arrival = spec.rate_hz > 0 ? now_ + s.arrivals.next_gap_ns() : NEVER;
+}
+
+void Simulation::set_service(Device d, const ServiceSpec &spec) {
+    config_.devices[d].service = spec;
+    dev_[d].service = ServiceProcess(spec, splitmix64(~(config_.seed * DEVICE_SLOTS + d) - (++reseeds_ << 32)));
+}
+
+void Simulation::arrive(Device d) {
+    DeviceState &s = dev_[d];
+    ++s.stats.arrivals;
+    size_t limit = config_.devices[d].queue_limit;
+    if (limit && s.queue.size() >= limit) ++s.stats.dropped;
+    else s.queue.push_back({++seq_, now_});
+    s.next_arrival = now_ + s.arrivals.next_gap_ns();
+}
+
+void Simulation::dispatch() {
+    bool has[DEVICE_SLOTS] = {};
+    long long seq[DEVICE_SLOTS] = {};
+    for (Device d : ALL_DEVICES) {
+        has[d] = !dev_[d].queue.empty() && effective_class(d, config_.devices[d].masked) > config_.tpr;
+        if (has[d]) seq[d] = dev_[d].queue.front().seq;
+    }
+    int d = choose_device(has, seq, config_.policy, last_served_);
+    if (!d) return;
+
+    DeviceState &s = dev_[d];
+    s.stats.latency.record(now_ - s.queue.front().arrival_ns);
+    s.queue.pop_front();
+    int64_t cost = s.service.next_ns();
+    busy_ = true;
+    current_ = (Device)d;
+    last_served_ = (Device)d;
+    isr_end_ = now_ + cost;
+    busy_ns_ += cost;
+}
+
+void Simulation::run_until(int64_t t_ns) {
+    if (t_ns > end_ns_) t_ns = end_ns_;
+    for (;;) {
+        int64_t next = busy_ ? isr_end_ : NEVER;
+        for (Device d : ALL_DEVICES) next = min(next, dev_[d].next_arrival);
+        if (next > t_ns) {
+            now_ = max(now_, t_ns);
+            return;
+        }
+        now_ = next;
+        // completion first, then arrivals at the same instant, then pick the next ISR
+        if (busy_ && isr_end_ == now_) {
+            busy_ = false;
+            ++dev_[current_].stats.dispatched;
+        }
+        for (Device d : ALL_DEVICES)
+            if (dev_[d].next_arrival == now_) arrive(d);
+        if (!busy_) dispatch();
+    }
+}
+
+void Simulation::clear_stats() {
+    for (DeviceState &s : dev_) s.stats = DeviceStats();
+    // the rest of an ISR in flight belongs to the new window; result() subtracts it back
+    busy_ns_ = busy_ ? isr_end_ - now_ : 0;
+    stats_start_ = now_;
+}
+
+SimResult Simulation::result() const {
+    SimResult r;
+    for (Device d : ALL_DEVICES) r.devices[d] = dev_[d].stats;
+    r.duration_ns = now_ - stats_start_;
+    // count only the part of an in-flight ISR that has already elapsed
+    r.busy_ns = busy_ ? busy_ns_ - (isr_end_ - now_) : busy_ns_;
+    return r;
+}
+
+static bool valid_device(int d) {
+    return d >= PRINTER && d <= KEYBOARD;
+}
+
+void Simulation::save(BinWriter &w) const {
+    for (const SimDevice &d : config_.devices) {
+        d.arrival.save(w);
+        d.service.save(w);
+        w.u8(d.masked ? 1 : 0);
+        w.u64(d.queue_limit);
+    }
+    w.u8((uint8_t)config_.policy);
+    w.u8((uint8_t)config_.tpr);
+    w.f64(config_.duration_s);
+    w.u64(config_.seed);
+
+    w.i64(end_ns_);
+    w.i64(now_);
+    w.i64(seq_);
+    w.u8(busy_ ? 1 : 0);
+    w.u8((uint8_t)current_);
+    w.i64(isr_end_);
+    w.u8((uint8_t)last_served_);
+    w.i64(busy_ns_);
+    w.u64(reseeds_);
+    w.i64(stats_start_);
+
+    for (const DeviceState &s : dev_) {
+        w.u64(s.queue.size());
+        for (const Pending &p : s.queue) {
+            w.i64(p.seq);
+            w.i64(p.arrival_ns);
+        }
+        w.i64(s.next_arrival);
+        s.arrivals.save(w);
+        s.service.save(w);
+        s.stats.save(w);
+    }
+}
+
+bool Simulation::load(BinReader &r) {
+    Simulation t(*this); // filled in, then swapped in only if everything decodes
+    for (SimDevice &d : t.config_.devices) {
+        if (!d.arrival.load(r) || !d.service.load(r)) return false;
+        d.masked = r.u8() != 0;
+        d.queue_limit = r.u64();
+    }
+    uint8_t policy = r.u8();
+    if (policy > (uint8_t)SchedulingPolicy::ROUND_ROBIN) return false;
+    t.config_.policy = (SchedulingPolicy)policy;
+    t.config_.tpr = r.u8();
+    if (t.config_.tpr > MAX_TPR) return false;
+    t.config_.duration_s = r.f64();
+    t.config_.seed = r.u64();
+
+    t.end_ns_ = r.i64();
+    t.now_ = r.i64();
+    t.seq_ = r.i64();
+    t.busy_ = r.u8() != 0;
+    int current = r.u8();
+    t.isr_end_ = r.i64();
+    int last = r.u8();
+    t.busy_ns_ = r.i64();
+    t.reseeds_ = r.u64();
+    t.stats_start_ = r.i64();
+    if (!valid_device(current) || !valid_device(last)) return false;
+    t.current_ = (Device)current;
+    t.last_served_ = (Device)last;
+
+    for (DeviceState &s : t.dev_) {
+        uint64_t n = r.u64();
+        s.queue.clear();
+        for (uint64_t i = 0; i < n && r.ok(); ++i) {
+            long long seq = r.i64();
+            int64_t arrival = r.i64();
+            s.queue.push_back({seq, arrival});
+        }
+        s.next_arrival = r.i64();
+        if (!s.arrivals.load(r) || !s.service.load(r) || !s.stats.load(r)) return false;
+    }
+    if (!r.ok()) return false;
+    *this = t;
+    return true;
+}
+
+} // namespace ics
@@ -0,0 +1,126 @@
+// Virtual-time (discrete-event) model of the interrupt controller.
+// Unlike InterruptController, nothing sleeps: the clock jumps from event to event,
+// so an hour of simulated traffic takes milliseconds. A Simulation is a plain
+// value - it owns no threads or locks - so many can run in parallel, and copying
+// one forks the run (see ics/whatif.h).
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "ics/arrival.h"
+#include "ics/binio.h"
+#include "ics/histogram.h"
+#include "ics/service.h"
+#include "ics/types.h"
+
+namespace ics {
+
+struct SimDevice {
+    ArrivalSpec arrival;        // arrival.rate_hz is the mean arrival rate
+    ServiceSpec service;        // ISR service time; service.mean_ms is the mean
+    bool masked = false;        // masked for the whole run
+    size_t queue_limit = 0;     // max pending per device, 0 = unbounded; extra arrivals are dropped
+};
+
+struct SimConfig {
+    std::array<SimDevice, DEVICE_SLOTS> devices{}; // indexed by Device
+    SchedulingPolicy policy = SchedulingPolicy::PRIORITY;
+    int tpr = 0;                // task priority register (0 to MAX_TPR): classes <= tpr are held back
+    double duration_s = 60;
+    uint64_t seed = 1;
+
+    // Same arrival ranges and ISR costs as the console simulator
+    static SimConfig defaults();
+};
+
+struct DeviceStats {
+    uint64_t arrivals = 0;
+    uint64_t dispatched = 0;
+    uint64_t dropped = 0;
+    LatencyHistogram latency;   // arrival to ISR start, ns
+
+    void merge(const DeviceStats &o);
+    void save(BinWriter &w) const;
+    bool load(BinReader &r);
+};
+
+struct SimResult {
+    std::array<DeviceStats, DEVICE_SLOTS> devices{};
+    int64_t duration_ns = 0;
+    int64_t busy_ns = 0;        // time spent inside ISRs
+
+    double throughput(Device d) const { return duration_ns ? devices[d].dispatched * 1e9 / duration_ns : 0; }
+    double drop_rate(Device d) const {
+        return devices[d].arrivals ? (double)devices[d].dropped / devices[d].arrivals : 0;
+    }
+};
+
+class Simulation {
+public:
+    explicit Simulation(const SimConfig &config);
+
+    // Advances virtual time to t_ns (or the configured duration, whichever is first)
+    void run_until(int64_t t_ns);
+    void run() { run_until(end_ns_); }
+
+    int64_t now() const { return now_; }
+    const SimConfig &config() const { return config_; }
+    SimResult result() const;
+
+    void set_mask(Device d, bool masked);
+    void set_policy(SchedulingPolicy p) { config_.policy = p; }
+    // Lowering the level can start an ISR at once. Returns false (and changes
+    // nothing) if level is outside 0..MAX_TPR, like InterruptController::set_tpr.
+    bool set_tpr(int level);
+    // Switches d to a new arrival process from now on (fresh, deterministic stream)
+    void set_arrival(Device d, const ArrivalSpec &spec);
+    // Same for the ISR service-time model; an ISR already in flight keeps its length
+    void set_service(Device d, const ServiceSpec &spec);
+    // Moves the end of the run (e.g. to continue a restored run past its original end)
+    void set_end(int64_t end_ns) { end_ns_ = end_ns; }
+    int64_t end() const { return end_ns_; }
+    // Starts a new measurement window at now(): stats, busy time and result().duration_ns
+    // count from here (e.g. to measure only the future of a forked copy)
+    void clear_stats();
+
+    // Complete state - configuration, queues, in-flight ISR, RNG streams, stats -
+    // so a loaded Simulation continues exactly as the saved one would have.
+    // load() replaces this Simulation's state only if the whole input is valid.
+    void save(BinWriter &w) const;
+    bool load(BinReader &r);
+
+private:
+    struct Pending {
+        long long seq;
+        int64_t arrival_ns;
+    };
+    struct DeviceState {
+        std::deque<Pending> queue;
+        int64_t next_arrival = 0;
+        ArrivalProcess arrivals;
+        ServiceProcess service;
+        DeviceStats stats;
+    };
+
+    void arrive(Device d);
+    void dispatch();
+
+    SimConfig config_;
+    int64_t end_ns_;
+    int64_t now_ = 0;
+    long long seq_ = 0;
+    std::vector<DeviceState> dev_; // indexed by Device
+
+    bool busy_ = false;         // an ISR is in flight
+    Device current_ = PRINTER;
+    int64_t isr_end_ = 0;
+    Device last_served_ = PRINTER;
+    int64_t busy_ns_ = 0;
+    int64_t stats_start_ = 0;   // start of the measurement window
+    uint64_t reseeds_ = 0;      // set_arrival() calls so far, to derive their streams
+};
+
+} // namespace ics
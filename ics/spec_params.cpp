@@ -0,0 +1,48 @@
+#include "ics/spec_params.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace ics {
+
+bool split_spec(const string &text, string &kind, vector<SpecParam> &params, string &error) {
+    kind = text.substr(0, text.find(':'));
+    params.clear();
+    stringstream ss(text.size() > kind.size() ? text.substr(kind.size() + 1) : "");
+    for (string kv; getline(ss, kv, ',');) {
+        size_t eq = kv.find('=');
+        if (eq == string::npos) {
+            error = "expected key=value, got '" + kv + "'";
+            return false;
+        }
+        SpecParam p;
+        p.key = kv.substr(0, eq);
+        p.value = kv.substr(eq + 1);
+        char *end;
+        p.number = strtod(p.value.c_str(), &end);
+        p.is_number = !p.value.empty() && !*end && p.number >= 0;
+        params.push_back(p);
+    }
+    return true;
+}
+
+bool load_ns_samples(const string &path, vector<int64_t> &out, string &error) {
+    ifstream in(path);
+    if (!in) {
+        error = path + ": cannot open";
+        return false;
+    }
+    out.clear();
+    for (long long v; in >> v;)
+        if (v > 0) out.push_back(v);
+    if (out.empty()) {
+        error = path + ": no positive samples";
+        return false;
+    }
+    return true;
+}
+
+} // namespace ics
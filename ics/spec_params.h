@@ -0,0 +1,22 @@
+// Parsing helpers for "kind:key=value,..." model specs (arrival and service models).
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ics {
+
+struct SpecParam {
+    std::string key, value;
+    double number = 0;          // valid when is_number
+    bool is_number = false;     // value parsed as a non-negative number
+};
+
+// Splits text into its kind and parameters; fails on a parameter without '='
+bool split_spec(const std::string &text, std::string &kind, std::vector<SpecParam> &params, std::string &error);
+
+// Reads whitespace-separated positive integers (ns) from path, skipping non-positive ones
+bool load_ns_samples(const std::string &path, std::vector<int64_t> &out, std::string &error);
+
+} // namespace ics
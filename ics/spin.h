@@ -0,0 +1,52 @@
+// Busy-wait primitives for the low-latency spin mode.
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace ics {
+
+// Tells the core we are spinning (x86 PAUSE / ARM YIELD): saves power and
+// frees pipeline resources for a hyperthread sibling.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+inline int64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Exponential pause backoff; past the cap it yields the core so an idle
+// spinner on a shared core does not starve the thread it is waiting for.
+class SpinBackoff {
+public:
+    void pause() {
+        if (n_ <= CAP) {
+            for (int i = 0; i < n_; ++i) cpu_relax();
+            n_ *= 2;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    void reset() { n_ = 1; }
+
+private:
+    static const int CAP = 1024;
+    int n_ = 1;
+};
+
+// Busy-waits until steady_ns() >= deadline_ns
+inline void spin_until(int64_t deadline_ns) {
+    while (steady_ns() < deadline_ns) cpu_relax();
+}
+
+} // namespace ics
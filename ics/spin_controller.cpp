@@ -0,0 +1,184 @@
+#include "ics/spin_controller.h"
+
+#include <random>
+
+#include "ics/affinity.h"
+#include "ics/interrupt_controller.h"
+#include "ics/spin.h"
+
+using namespace std;
+
+namespace ics {
+
+// Waits this far ahead of an arrival by yielding instead of spinning,
+// so slow devices do not monopolize a core they share
+static const int64_t YIELD_AHEAD_NS = 200000;
+
+SpinConfig SpinConfig::defaults() {
+    SpinConfig c;
+    for (Device d : ALL_DEVICES) {
+        c.arrivals[d].kind = ArrivalKind::POISSON;
+        c.arrivals[d].rate_hz = 100000;
+        c.service[d] = ServiceSpec::constant_ms(0.001);
+    }
+    return c;
+}
+
+SpinController::SpinController(const SpinConfig &config) : config_(config) {
+    for (Device d : ALL_DEVICES) producers_[d].ring.reset(new SpscRing<Entry>(config_.ring_capacity));
+    for (size_t w = 0; w < config_.tpr.size() && w < tpr_.size(); ++w) tpr_[w].level = config_.tpr[w];
+}
+
+SpinController::~SpinController() {
+    stop();
+}
+
+void SpinController::start() {
+    if (running_) return;
+    running_ = true;
+    started_ns_ = steady_ns();
+    unsigned workers = min(max(config_.workers, 1u), (unsigned)DEVICE_SLOTS - 1);
+    worker_stats_.assign(workers, WorkerStats());
+    for (unsigned w = 0; w < workers; ++w) workers_.emplace_back(&SpinController::controller_loop, this, w);
+    for (Device d : ALL_DEVICES) devices_.emplace_back(&SpinController::device_loop, this, d);
+}
+
+void SpinController::stop() {
+    if (!running_) return;
+    running_ = false;
+    for (auto &t : devices_) t.join();
+    devices_.clear();
+    for (auto &t : workers_) t.join();
+    workers_.clear();
+    stopped_ns_ = steady_ns();
+}
+
+void SpinController::set_mask(Device d, bool masked) {
+    if (masked) masks_.fetch_or(1u << d);
+    else masks_.fetch_and(~(1u << d));
+}
+
+bool SpinController::set_tpr(unsigned worker, int level) {
+    unsigned workers = running_ ? (unsigned)worker_stats_.size() : (unsigned)tpr_.size();
+    if (worker >= workers || level < 0 || level > MAX_TPR) return false;
+    tpr_[worker].level.store(level, memory_order_relaxed);
+    return true;
+}
+
+void SpinController::device_loop(Device d) {
+    placement_.add(apply_placement(device_name(d), config_.device_threads[d]));
+    random_device rd;
+    ArrivalProcess arrivals(config_.arrivals[d], ((uint64_t)rd() << 32) | rd());
+    Producer &p = producers_[d];
+    long long seq = 0;
+    int64_t next = steady_ns() + arrivals.next_gap_ns();
+    while (running_.load(memory_order_relaxed)) {
+        int64_t now = steady_ns();
+        if (now < next) {
+            if (next - now > YIELD_AHEAD_NS) this_thread::yield();
+            else cpu_relax();
+            continue;
+        }
+        // raise at the actual time; if we fell behind schedule, catch up without skipping arrivals
+        ++p.stats.arrivals;
+        if (!p.ring->try_push({now, ++seq})) ++p.stats.dropped;
+        next += arrivals.next_gap_ns();
+    }
+}
+
+void SpinController::controller_loop(unsigned worker) {
+    unsigned workers = (unsigned)worker_stats_.size();
+    ThreadPlacement placement = config_.controller_thread;
+    if (placement.cpu >= 0) placement.cpu += worker;
+    placement_.add(apply_placement(workers > 1 ? "controller " + to_string(worker) : "controller", placement));
+    unsigned owned = 0; // this worker's IRQ lines, as bits
+    for (int i = 0; i < DEVICE_SLOTS - 1; ++i)
+        if (i % workers == worker) owned |= 1u << ALL_DEVICES[i];
+    unsigned published = 0;
+    WorkerStats &stats = worker_stats_[worker];
+    const atomic<int> &tpr = tpr_[worker].level;
+
+    random_device rd;
+    vector<ServiceProcess> services;
+    for (int d = 0; d < DEVICE_SLOTS; ++d) services.emplace_back(config_.service[d], ((uint64_t)rd() << 32) | rd());
+    unique_ptr<CpuWorkKernel> kernel;
+    if (config_.work != IsrWork::SLEEP) {
+        kernel.reset(new CpuWorkKernel(config_.work));
+        kernel->calibrate();
+    }
+
+    SpinBackoff backoff;
+    Device last_served = PRINTER;
+    while (running_.load(memory_order_relaxed)) {
+        unsigned masked = masks_.load(memory_order_relaxed);
+        int level = tpr.load(memory_order_relaxed);
+        bool has[DEVICE_SLOTS] = {};
+        long long t[DEVICE_SLOTS] = {};
+        const Entry *front[DEVICE_SLOTS] = {};
+        unsigned ready = 0;
+        for (Device d : ALL_DEVICES) {
+            if (!(owned & (1u << d)) || effective_class(d, masked & (1u << d)) <= level) continue;
+            front[d] = producers_[d].ring->front();
+            if (front[d]) {
+                has[d] = true;
+                t[d] = front[d]->t_ns;
+                ready |= 1u << d;
+            }
+        }
+        if (workers > 1 && ready != published) {
+            // touch the shared word only when this shard's state changes
+            if (ready & ~published) ready_.fetch_or(ready & ~published, memory_order_release);
+            if (published & ~ready) ready_.fetch_and(~(published & ~ready), memory_order_release);
+            published = ready;
+        }
+        int d = choose_device(has, t, config_.policy, last_served);
+        if (!d) {
+            ++stats.idle_polls;
+            backoff.pause();
+            continue;
+        }
+        // device numbers are priorities, so any bit above d is higher-priority work
+        if (workers > 1 && config_.policy == SchedulingPolicy::PRIORITY &&
+            (ready_.load(memory_order_acquire) & ~owned & ~((2u << d) - 1))) {
+            ++stats.deferrals;
+            backoff.pause();
+            continue;
+        }
+        backoff.reset();
+
+        int64_t start = steady_ns();
+        served_[d].latency.record(start - front[d]->t_ns);
+        producers_[d].ring->pop();
+        last_served = (Device)d;
+        if (workers > 1 && !producers_[d].ring->front()) {
+            // drained: others need not wait on this line while its last ISR runs
+            ready_.fetch_and(~(1u << d), memory_order_release);
+            published &= ~(1u << d);
+        }
+
+        int64_t cost = services[d].next_ns();
+        if (kernel) kernel->run(cost);
+        else if (cost > 0) spin_until(start + cost);
+        ++served_[d].dispatched;
+    }
+}
+
+SpinReport SpinController::report() const {
+    SpinReport r;
+    for (Device d : ALL_DEVICES) {
+        r.devices[d] = served_[d];
+        r.devices[d].arrivals = producers_[d].stats.arrivals;
+        r.devices[d].dropped = producers_[d].stats.dropped;
+    }
+    r.seconds = (stopped_ns_ - started_ns_) / 1e9;
+    r.workers = (unsigned)worker_stats_.size();
+    for (const WorkerStats &w : worker_stats_) {
+        r.idle_polls += w.idle_polls;
+        r.deferrals += w.deferrals;
+    }
+    for (size_t w = 0; w < worker_stats_.size(); ++w) r.tpr.push_back(tpr_[w].level);
+    r.placement = placement_.records();
+    return r;
+}
+
+} // namespace ics
@@ -0,0 +1,61 @@
+// Bounded single-producer/single-consumer ring. Head and tail live on separate
+// cache lines, and each side caches the other's index so the common case
+// touches no shared line at all.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace ics {
+
+template <class T>
+class SpscRing {
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) {
+        size_t n = 2;
+        while (n < capacity) n <<= 1;
+        buf_.resize(n);
+        mask_ = n - 1;
+    }
+
+    // producer side
+    bool try_push(const T &v) {
+        size_t t = tail_.load(std::memory_order_relaxed);
+        if (t - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (t - head_cache_ > mask_) return false;
+        }
+        buf_[t & mask_] = v;
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side: oldest element, or nullptr when empty
+    const T *front() {
+        size_t h = head_.load(std::memory_order_relaxed);
+        if (h == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (h == tail_cache_) return nullptr;
+        }
+        return &buf_[h & mask_];
+    }
+
+    // consumer side: drop the element returned by front()
+    void pop() { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    size_t size_approx() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> buf_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> head_{0};   // written by the consumer
+    size_t tail_cache_ = 0;                      // consumer's view of tail_
+    alignas(64) std::atomic<size_t> tail_{0};   // written by the producer
+    size_t head_cache_ = 0;                      // producer's view of head_
+};
+
+} // namespace ics
@@ -0,0 +1,115 @@
+#include "ics/trace_sink.h"
+
+#include <fstream>
+
+using namespace std;
+
+namespace ics {
+
+static const size_t FLUSH_EVENTS = 4096;
+
+static const char *isr_trace_name(Device d) {
+    switch(d) {
+        case KEYBOARD: return "Keyboard ISR";
+        case MOUSE: return "Mouse ISR";
+        case PRINTER: return "Printer ISR";
+    }
+    return "ISR";
+}
+
+TraceSink::TraceSink(const string &path) : path_(path), t0_(chrono::steady_clock::now()) {
+    writer_ = thread(&TraceSink::writer_loop, this);
+}
+
+TraceSink::~TraceSink() {
+    {
+        lock_guard<mutex> lg(mtx_);
+        done_ = true;
+    }
+    cv_.notify_one();
+    writer_.join();
+}
+
+long long TraceSink::us(time_point t) const {
+    return chrono::duration_cast<chrono::microseconds>(t - t0_).count();
+}
+
+void TraceSink::emit(const Event &e) {
+    bool flush;
+    {
+        lock_guard<mutex> lg(mtx_);
+        buf_.push_back(e);
+        flush = buf_.size() >= FLUSH_EVENTS;
+    }
+    if (flush) cv_.notify_one();
+}
+
+void TraceSink::span(int pid, int tid, const char *name, long long seq, time_point from, time_point to) {
+    emit({'X', pid, tid, name, us(from), us(to) - us(from), seq});
+}
+
+void TraceSink::instant(int pid, int tid, const char *name) {
+    emit({'i', pid, tid, name, us(chrono::steady_clock::now()), 0, -1});
+}
+
+void TraceSink::isr_finished(const InterruptEvent &ev, time_point start, time_point end) {
+    span(PID_DEVICES, ev.dev, "queued", ev.seq, ev.timestamp, start);
+    span(PID_DEVICES, ev.dev, "ISR", ev.seq, start, end);
+    span(PID_CONTROLLER, 0, isr_trace_name(ev.dev), ev.seq, start, end);
+}
+
+void TraceSink::interrupt_masked(const InterruptEvent &ev) {
+    instant(PID_DEVICES, ev.dev, "ignored (masked)");
+}
+
+void TraceSink::set_controller_track(const string &name) {
+    lock_guard<mutex> lg(mtx_);
+    controller_track_ = name;
+}
+
+void TraceSink::mask_changed(Device dev, bool masked) {
+    instant(PID_DEVICES, dev, masked ? "mask" : "unmask");
+}
+
+static void write_event(ostream &out, char ph, int pid, int tid, const char *name,
+                        long long ts_us, long long dur_us, long long seq) {
+    out << ",\n{\"ph\":\"" << ph << "\",\"pid\":" << pid << ",\"tid\":" << tid
+        << ",\"name\":\"" << name << "\",\"ts\":" << ts_us;
+    if (ph == 'X') out << ",\"dur\":" << dur_us;
+    else out << ",\"s\":\"t\"";
+    if (seq >= 0) out << ",\"args\":{\"seq\":" << seq << "}";
+    out << "}";
+}
+
+static void write_metadata(ostream &out, int pid, int tid, const char *kind, const string &name) {
+    out << ",\n{\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+        << ",\"name\":\"" << kind << "\",\"args\":{\"name\":\"" << name << "\"}}";
+}
+
+void TraceSink::writer_loop() {
+    ofstream out(path_, ios::trunc);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+        << "{\"ph\":\"M\",\"pid\":" << PID_DEVICES << ",\"name\":\"process_name\",\"args\":{\"name\":\"Devices\"}}";
+    write_metadata(out, PID_CONTROLLER, 0, "process_name", "Interrupt Controller");
+    for (Device d : ALL_DEVICES) write_metadata(out, PID_DEVICES, d, "thread_name", device_name(d));
+
+    vector<Event> batch;
+    unique_lock<mutex> ul(mtx_);
+    for (;;) {
+        cv_.wait_for(ul, chrono::milliseconds(500), [this]{ return buf_.size() >= FLUSH_EVENTS || done_; });
+        batch.swap(buf_);
+        bool done = done_;
+        ul.unlock();
+        for (auto &e : batch) write_event(out, e.ph, e.pid, e.tid, e.name, e.ts_us, e.dur_us, e.seq);
+        batch.clear();
+        out.flush();
+        if (done) break;
+        ul.lock();
+    }
+    // metadata may come anywhere in the array; by now the controller's CPU is known
+    ul.lock();
+    write_metadata(out, PID_CONTROLLER, 0, "thread_name", controller_track_);
+    out << "\n]}\n";
+}
+
+} // namespace ics
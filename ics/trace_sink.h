@@ -0,0 +1,63 @@
+// Chrome Trace Event JSON export (open in chrome://tracing or ui.perfetto.dev).
+// One track per device (queue wait + ISR) and per controller CPU (ISR), plus
+// instants for mask changes and masked interrupts. The dispatch path only appends
+// a POD record; formatting and file I/O happen on a writer thread.
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ics/isr_sink.h"
+
+namespace ics {
+
+class TraceSink : public IsrSink {
+public:
+    explicit TraceSink(const std::string &path);
+    ~TraceSink() override; // flushes and closes the JSON document
+    TraceSink(const TraceSink &) = delete;
+    TraceSink &operator=(const TraceSink &) = delete;
+
+    const std::string &path() const { return path_; }
+    // Name of the controller's ISR track, e.g. "CPU 2" once the controller's CPU is
+    // known (default "controller"). Written when the trace closes, so it can be set
+    // any time before destruction.
+    void set_controller_track(const std::string &name);
+
+    void isr_finished(const InterruptEvent &ev, time_point start, time_point end) override;
+    void interrupt_masked(const InterruptEvent &ev) override;
+    void mask_changed(Device dev, bool masked) override;
+
+    static const int PID_DEVICES = 1;
+    static const int PID_CONTROLLER = 2;
+
+private:
+    struct Event {
+        char ph;              // 'X' = complete span, 'i' = instant
+        int pid, tid;
+        const char *name;     // must be a literal: it outlives the call
+        long long ts_us, dur_us;
+        long long seq;        // -1 when not tied to an interrupt
+    };
+
+    long long us(time_point t) const;
+    void emit(const Event &e);
+    void span(int pid, int tid, const char *name, long long seq, time_point from, time_point to);
+    void instant(int pid, int tid, const char *name);
+    void writer_loop();
+
+    std::string path_;
+    time_point t0_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::vector<Event> buf_;
+    bool done_ = false;
+    std::string controller_track_ = "controller";
+    std::thread writer_;
+};
+
+} // namespace ics
@@ -0,0 +1,79 @@
+#include "ics/tsc_clock.h"
+
+#ifdef ICS_HAS_TSC
+#include <cpuid.h>
+#endif
+
+#include "ics/spin.h"
+
+using namespace std;
+
+namespace ics {
+
+bool parse_time_source(const string &s, TimeSource &source) {
+    if (s == "steady") source = TimeSource::STEADY;
+    else if (s == "tsc") source = TimeSource::TSC;
+    else return false;
+    return true;
+}
+
+const char *time_source_name(TimeSource source) {
+    return source == TimeSource::TSC ? "tsc" : "steady";
+}
+
+bool tsc_invariant(string *why) {
+#ifdef ICS_HAS_TSC
+    unsigned a, b, c, d;
+    if (__get_cpuid(0x80000007, &a, &b, &c, &d) && (d & (1u << 8))) return true;
+    if (why) *why = "CPU does not report an invariant TSC";
+    return false;
+#else
+    if (why) *why = "no TSC on this architecture";
+    return false;
+#endif
+}
+
+// One (steady, tsc) pair, taking the TSC between two clock reads so it is
+// attributed to their midpoint
+static void paired_reading(int64_t &ns, uint64_t &tsc) {
+    int64_t a = steady_ns();
+    tsc = read_tsc();
+    int64_t b = steady_ns();
+    ns = a + (b - a) / 2;
+}
+
+static TscCalibration calibrate() {
+    TscCalibration c;
+    int64_t ns0, ns1;
+    uint64_t tsc0, tsc1;
+    paired_reading(ns0, tsc0);
+    while (steady_ns() - ns0 < 20000000) {
+        // spin: sleeping would only add scheduler noise at the end points
+    }
+    paired_reading(ns1, tsc1);
+    c.tsc0 = tsc1;
+    c.steady0_ns = ns1;
+    c.ns_per_tick = tsc1 > tsc0 ? (double)(ns1 - ns0) / (double)(tsc1 - tsc0) : 0;
+    return c;
+}
+
+const TscCalibration &tsc_calibration() {
+    static const TscCalibration c = calibrate();
+    return c;
+}
+
+EventClock::EventClock(TimeSource requested) {
+    if (requested != TimeSource::TSC) return;
+    if (!tsc_invariant(&why_)) return;
+    const TscCalibration &c = tsc_calibration();
+    if (c.ns_per_tick <= 0) {
+        why_ = "TSC did not advance during calibration";
+        return;
+    }
+    tsc_ = true;
+    ns_per_tick_ = c.ns_per_tick;
+    tsc0_ = c.tsc0;
+    steady0_ns_ = c.steady0_ns;
+}
+
+} // namespace ics
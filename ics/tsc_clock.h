@@ -0,0 +1,70 @@
+// Event timestamps from the invariant TSC: rdtsc plus one multiply-add instead of
+// a clock_gettime call per event. The TSC is calibrated once (about 20 ms, on
+// first use) against steady_clock and readings are converted to steady_clock
+// time points, so they mix freely with steady_clock::now() and with timestamps
+// other processes take from CLOCK_MONOTONIC.
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ICS_HAS_TSC 1
+#include <x86intrin.h>
+#endif
+
+namespace ics {
+
+enum class TimeSource { STEADY, TSC };
+
+// Accepts "steady" and "tsc"
+bool parse_time_source(const std::string &s, TimeSource &source);
+const char *time_source_name(TimeSource source);
+
+// True if the CPU advertises an invariant TSC (constant rate, runs in deep
+// C-states); otherwise why not
+bool tsc_invariant(std::string *why = nullptr);
+
+struct TscCalibration {
+    double ns_per_tick = 0;
+    uint64_t tsc0 = 0;          // TSC reading at ...
+    int64_t steady0_ns = 0;     // ... this steady_clock time
+};
+
+// Measured on first call; thread-safe
+const TscCalibration &tsc_calibration();
+
+inline uint64_t read_tsc() {
+#ifdef ICS_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Reads timestamps from the configured source. Falls back to steady_clock when
+// the TSC is not invariant; source() reports what is actually used.
+class EventClock {
+public:
+    explicit EventClock(TimeSource requested = TimeSource::STEADY);
+
+    std::chrono::steady_clock::time_point now() const {
+        if (!tsc_) return std::chrono::steady_clock::now();
+        // signed, so a core whose TSC trails the calibrating one yields a small negative delta
+        int64_t ticks = (int64_t)(read_tsc() - tsc0_);
+        int64_t ns = steady0_ns_ + (int64_t)((double)ticks * ns_per_tick_);
+        return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(ns));
+    }
+    TimeSource source() const { return tsc_ ? TimeSource::TSC : TimeSource::STEADY; }
+    const std::string &fallback_reason() const { return why_; }
+
+private:
+    bool tsc_ = false;
+    double ns_per_tick_ = 0;
+    uint64_t tsc0_ = 0;
+    int64_t steady0_ns_ = 0;
+    std::string why_;
+};
+
+} // namespace ics
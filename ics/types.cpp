@@ -0,0 +1,59 @@
+#include "ics/types.h"
+
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+namespace ics {
+
+string device_name(Device d) {
+    switch(d) {
+        case KEYBOARD: return "Keyboard";
+        case MOUSE: return "Mouse";
+        case PRINTER: return "Printer";
+    }
+    return "Unknown";
+}
+
+const char *policy_name(SchedulingPolicy p) {
+    switch(p) {
+        case SchedulingPolicy::PRIORITY: return "priority";
+        case SchedulingPolicy::FIFO: return "fifo";
+        case SchedulingPolicy::ROUND_ROBIN: return "rr";
+    }
+    return "unknown";
+}
+
+bool parse_policy(const string &s, SchedulingPolicy &p) {
+    if (s == "priority") p = SchedulingPolicy::PRIORITY;
+    else if (s == "fifo") p = SchedulingPolicy::FIFO;
+    else if (s == "rr" || s == "round-robin") p = SchedulingPolicy::ROUND_ROBIN;
+    else return false;
+    return true;
+}
+
+bool parse_tpr(const string &s, int &level) {
+    char *end = nullptr;
+    long v = strtol(s.c_str(), &end, 10);
+    if (s.empty() || *end || v < 0 || v > MAX_TPR) return false;
+    level = (int)v;
+    return true;
+}
+
+string format_local_time(chrono::system_clock::time_point t) {
+    time_t tt = chrono::system_clock::to_time_t(t);
+    tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &tt);
+#else
+    localtime_r(&tt, &local);
+#endif
+    stringstream ss;
+    ss << put_time(&local, "%F %T");
+    return ss.str();
+}
+
+} // namespace ics
@@ -0,0 +1,60 @@
+// Core value types shared by the controller, device models and sinks.
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace ics {
+
+// Numeric value doubles as priority: KEYBOARD (3) > MOUSE (2) > PRINTER (1)
+enum Device { PRINTER = 1, MOUSE = 2, KEYBOARD = 3 };
+
+const int DEVICE_SLOTS = 4; // arrays indexed directly by Device
+const Device ALL_DEVICES[] = {KEYBOARD, MOUSE, PRINTER};
+
+// Round-robin rotation order: KEYBOARD -> MOUSE -> PRINTER -> KEYBOARD
+inline Device next_in_rotation(Device d) { return d == PRINTER ? KEYBOARD : (Device)(d - 1); }
+
+// APIC-style priority classes: each device's interrupt vector sits in the class
+// equal to its priority, and a task priority register (TPR) at level L blocks
+// every class <= L, so one register write holds back a whole group of devices
+// (0 accepts all, 3 and above block all three).
+inline int priority_class(Device d) { return (int)d; }
+const int MAX_TPR = 15; // 4-bit register, as on the APIC
+
+// Effective class after the per-device mask: a masked device behaves as class 0,
+// which every TPR blocks, so deliverability is the single compare
+// effective_class(d, masked) > tpr
+inline int effective_class(Device d, bool masked) { return masked ? 0 : priority_class(d); }
+
+// How the controller chooses among pending, unmasked interrupts
+enum class SchedulingPolicy {
+    PRIORITY,     // highest device priority, oldest first within a device
+    FIFO,         // oldest interrupt first, regardless of device
+    ROUND_ROBIN   // oldest interrupt of the next device in rotation after the last served one
+};
+
+struct InterruptEvent {
+    Device dev;
+    long long seq; // unique id, increasing within a device (see device_seq)
+    std::chrono::steady_clock::time_point timestamp;
+};
+
+// Sequence number of the n-th (1-based) event of device d. Devices count
+// independently, so no counter is shared between them; the device in the low bits
+// keeps numbers unique across devices. Orders events of one device exactly; across
+// devices, order by timestamp.
+inline long long device_seq(Device d, long long n) {
+    return n * DEVICE_SLOTS + d;
+}
+
+std::string device_name(Device d);
+const char *policy_name(SchedulingPolicy p);
+// Accepts "priority", "fifo", "rr"/"round-robin"; returns false otherwise
+bool parse_policy(const std::string &s, SchedulingPolicy &p);
+// A whole number from 0 to MAX_TPR; returns false otherwise
+bool parse_tpr(const std::string &s, int &level);
+// "YYYY-MM-DD HH:MM:SS" in local time, as used by the console and ISR log
+std::string format_local_time(std::chrono::system_clock::time_point t);
+
+} // namespace ics
@@ -0,0 +1,23 @@
+#include "ics/whatif.h"
+
+#include "ics/parallel.h"
+
+using namespace std;
+
+namespace ics {
+
+vector<BranchOutcome> run_branches(const Simulation &base, const vector<Branch> &branches, unsigned threads) {
+    vector<BranchOutcome> outcomes(branches.size());
+    parallel_for(branches.size(), threads, [&](size_t i) {
+        Simulation fork = base;
+        fork.clear_stats();
+        BranchOutcome &o = outcomes[i];
+        run_scenario_virtual(branches[i].scenario, fork, true, o.error);
+        o.name = branches[i].name;
+        o.result = fork.result();
+        o.expectations = check_expectations(branches[i].scenario, o.result.devices, o.result.duration_ns / 1e9);
+    });
+    return outcomes;
+}
+
+} // namespace ics
@@ -0,0 +1,34 @@
+// What-if branching in virtual time: a running Simulation is a plain value, so
+// copying it forks the run - queues, in-flight ISR, RNG streams and all. Each
+// branch plays its own scenario (mask actions, policy, arrival or service
+// changes) on a copy of the same state, on separate threads, and is measured
+// from the fork point only, so the futures can be compared side by side.
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ics/scenario.h"
+#include "ics/simulation.h"
+
+namespace ics {
+
+struct Branch {
+    std::string name;
+    Scenario scenario;          // times count from the fork; settings apply at the fork
+};
+
+struct BranchOutcome {
+    std::string name;
+    SimResult result;           // the branch's own window: duration_ns is its scenario's length
+    std::vector<ExpectationResult> expectations;
+    std::string error;          // set if the simulation rejected one of the branch's commands
+};
+
+// Runs every branch on its own copy of base (which is left as it was) on up to
+// `threads` workers (0 = one per core). Outcomes are in branch order and do not
+// depend on the thread count.
+std::vector<BranchOutcome> run_branches(const Simulation &base, const std::vector<Branch> &branches,
+                                        unsigned threads = 0);
+
+} // namespace ics
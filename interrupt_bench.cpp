@@ -0,0 +1,308 @@
+/*
+Interrupt Controller Microbenchmarks
+Self-contained, Google Benchmark-style timing of the dispatch path.
+
+Build:
+    cmake --preset release && cmake --build --preset release --target interrupt_bench
+Run:
+    ./interrupt_bench [--json FILE] [--filter SUBSTRING] [--min-time SECONDS]
+
+Each benchmark is re-run with a growing iteration count until one run takes at
+least --min-time (default 0.2s); the reported figure is the time per operation
+of that run. --json writes the results for regression tracking.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ics/arrival.h"
+#include "ics/interrupt_controller.h"
+#include "ics/isr_log.h"
+#include "ics/pending_queue.h"
+#include "ics/spsc_ring.h"
+#include "ics/tsc_clock.h"
+
+using namespace std;
+using namespace ics;
+
+struct BenchResult {
+    string name;
+    long long iterations;
+    double real_ns;        // total wall time of the final run
+    double ns_per_op;
+};
+
+double bench_min_time = 0.2;
+string bench_filter;
+vector<BenchResult> bench_results;
+
+// body(iters) performs iters operations and returns the nanoseconds it spent on them,
+// so setup that is not part of the measured operation can be excluded
+void run_bench(const string &name, const function<double(long long)> &body) {
+    if (!bench_filter.empty() && name.find(bench_filter) == string::npos) return;
+    long long iters = 1;
+    double ns = 0;
+    for (;;) {
+        ns = body(iters);
+        if (ns >= bench_min_time * 1e9 || iters >= (1LL << 40)) break;
+        // aim a bit past the target, but never grow more than 10x per step
+        double scale = ns > 0 ? bench_min_time * 1e9 * 1.4 / ns : 10;
+        iters = (long long)(iters * (scale > 10 ? 10 : scale < 2 ? 2 : scale));
+    }
+    BenchResult r{name, iters, ns, ns / iters};
+    bench_results.push_back(r);
+    cout << left << setw(48) << r.name << right << setw(14) << fixed << setprecision(1) << r.ns_per_op << " ns"
+         << setw(14) << r.iterations << endl;
+}
+
+double elapsed_ns(chrono::steady_clock::time_point t0) {
+    return (double)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+}
+
+ControllerConfig zero_cost_config() {
+    ControllerConfig cfg;
+    cfg.service.fill(ServiceSpec::constant_ms(0));
+    return cfg;
+}
+
+vector<InterruptEvent> make_backlog(size_t backlog, unsigned seed) {
+    mt19937 gen(seed);
+    uniform_int_distribution<> dev(PRINTER, KEYBOARD);
+    vector<InterruptEvent> events;
+    long long count[DEVICE_SLOTS] = {};
+    for (size_t i = 0; i < backlog; ++i) {
+        Device d = (Device)dev(gen);
+        events.push_back({d, device_seq(d, ++count[d]), chrono::steady_clock::now()});
+    }
+    return events;
+}
+
+double bm_enqueue(long long iters) {
+    const long long batch = 4096; // keep the backlog bounded like a real controller would
+    double ns = 0;
+    for (long long done = 0; done < iters; done += batch) {
+        long long n = min(batch, iters - done);
+        InterruptController ic(zero_cost_config()); // never started, so nothing drains it
+        auto t0 = chrono::steady_clock::now();
+        for (long long i = 0; i < n; ++i) ic.raise((Device)(PRINTER + i % 3));
+        ns += elapsed_ns(t0);
+    }
+    return ns;
+}
+
+function<double(long long)> bm_select(size_t backlog, bool mask_top) {
+    return [backlog, mask_top](long long iters) {
+        vector<InterruptEvent> events = make_backlog(backlog, 42);
+        MaskRegister masks{};
+        masks[KEYBOARD] = mask_top;
+        volatile int sink = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (long long i = 0; i < iters; ++i) sink = select_next(events, masks);
+        (void)sink;
+        return elapsed_ns(t0);
+    };
+}
+
+// Same backlog in the controller's structure-of-arrays queue, with the kernel forced
+// to `level`; checks once that it picks the same event as the vector version
+function<double(long long)> bm_select_soa(size_t backlog, bool mask_top, SimdLevel level) {
+    return [backlog, mask_top, level](long long iters) {
+        vector<InterruptEvent> events = make_backlog(backlog, 42);
+        PendingQueue pending;
+        for (const InterruptEvent &ev : events) pending.push_back(ev);
+        MaskRegister masks{};
+        masks[KEYBOARD] = mask_top;
+        SimdLevel saved = simd_level();
+        set_simd_level(level);
+        for (SchedulingPolicy policy : {SchedulingPolicy::PRIORITY, SchedulingPolicy::FIFO, SchedulingPolicy::ROUND_ROBIN})
+            if (select_next(pending, masks, policy) != select_next(events, masks, policy))
+                cerr << "select_next mismatch for " << simd_name(level) << " (" << policy_name(policy) << ") at backlog "
+                     << backlog << endl;
+        volatile int sink = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (long long i = 0; i < iters; ++i) sink = select_next(pending, masks);
+        (void)sink;
+        double ns = elapsed_ns(t0);
+        set_simd_level(saved);
+        return ns;
+    };
+}
+
+double bm_mask_toggle(long long iters) {
+    InterruptController ic(zero_cost_config());
+    auto t0 = chrono::steady_clock::now();
+    for (long long i = 0; i < iters; ++i) ic.set_mask(KEYBOARD, (i & 1) == 0);
+    return elapsed_ns(t0);
+}
+
+const char *BENCH_LOG = "bench_isr_log.txt";
+
+double bm_log_append(long long iters) {
+    const string line = "START | Keyboard | seq=123456 | 2025-10-25 01:55:58";
+    LogOptions options;
+    options.path = BENCH_LOG; // truncated on open so repeated runs do not grow the file
+    IsrLog log(options);
+    auto t0 = chrono::steady_clock::now();
+    for (long long i = 0; i < iters; ++i) log.append(line);
+    return elapsed_ns(t0);
+}
+
+function<double(long long)> bm_arrival_gap(const string &spec_text) {
+    return [spec_text](long long iters) {
+        ArrivalSpec spec;
+        string error;
+        ArrivalSpec::parse(spec_text, spec, error);
+        ArrivalProcess process(spec, 42);
+        volatile int64_t sink = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (long long i = 0; i < iters; ++i) sink = process.next_gap_ns();
+        (void)sink;
+        return elapsed_ns(t0);
+    };
+}
+
+// Producer enqueues iters events while the controller thread drains them with zero-cost ISRs
+double bm_dispatch_throughput(long long iters) {
+    InterruptController ic(zero_cost_config());
+    auto t0 = chrono::steady_clock::now();
+    ic.start();
+    for (long long i = 0; i < iters; ++i) ic.raise((Device)(PRINTER + i % 3));
+    while (ic.dispatched() < iters) this_thread::yield();
+    double ns = elapsed_ns(t0);
+    ic.stop();
+    return ns;
+}
+
+// Cost of one event timestamp from each source
+function<double(long long)> bm_timestamp(TimeSource source) {
+    return [source](long long iters) {
+        EventClock clock(source);
+        volatile long long sink = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (long long i = 0; i < iters; ++i) sink = clock.now().time_since_epoch().count();
+        (void)sink;
+        return elapsed_ns(t0);
+    };
+}
+
+// Single-threaded push/pop pair: the uncontended cost of the spin-mode device ring
+double bm_spsc_push_pop(long long iters) {
+    SpscRing<InterruptEvent> ring(1024);
+    InterruptEvent ev{KEYBOARD, 0, chrono::steady_clock::now()};
+    volatile long long sink = 0;
+    auto t0 = chrono::steady_clock::now();
+    for (long long i = 0; i < iters; ++i) {
+        ev.seq = i;
+        ring.try_push(ev);
+        sink = ring.front()->seq;
+        ring.pop();
+    }
+    (void)sink;
+    return elapsed_ns(t0);
+}
+
+// Time per raise() with `producers` threads feeding one started controller that drains
+// them with zero-cost ISRs: every raise takes the controller's queue lock, so this
+// shows how the dispatch path scales under producer contention. Runs in batches that
+// are drained (untimed) in between, so the backlog and the selection scan stay bounded.
+function<double(long long)> bm_concurrent_raise(int producers) {
+    return [producers](long long iters) {
+        const long long batch = 4096;
+        InterruptController ic(zero_cost_config());
+        ic.start();
+        double ns = 0;
+        long long raised = 0;
+        while (raised < iters) {
+            long long per_thread = (min(batch, iters - raised) + producers - 1) / producers;
+            atomic<bool> go{false};
+            vector<thread> threads;
+            for (int p = 0; p < producers; ++p)
+                threads.emplace_back([&ic, &go, p, per_thread] {
+                    while (!go.load(memory_order_acquire)) this_thread::yield();
+                    for (long long i = 0; i < per_thread; ++i) ic.raise((Device)(PRINTER + (p + i) % 3));
+                });
+            auto t0 = chrono::steady_clock::now();
+            go.store(true, memory_order_release);
+            for (auto &t : threads) t.join();
+            ns += elapsed_ns(t0);
+            raised += per_thread * producers;
+            while (ic.dispatched() < raised) this_thread::yield();
+        }
+        ic.stop();
+        return ns * iters / raised;
+    };
+}
+
+void write_json(const string &path) {
+    ofstream out(path, ios::trunc);
+    time_t now = chrono::system_clock::to_time_t(chrono::system_clock::now());
+    out << "{\n  \"context\": {\"date\": \"" << put_time(localtime(&now), "%FT%T")
+        << "\", \"num_cpus\": " << thread::hardware_concurrency() << ", \"min_time\": " << bench_min_time << "},\n"
+        << "  \"benchmarks\": [";
+    for (size_t i = 0; i < bench_results.size(); ++i) {
+        const BenchResult &r = bench_results[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+            << ", \"real_time\": " << fixed << setprecision(3) << r.ns_per_op << ", \"time_unit\": \"ns\"}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+int main(int argc, char **argv) {
+    string json_path;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) json_path = argv[++i];
+        else if (arg == "--filter" && i + 1 < argc) bench_filter = argv[++i];
+        else if (arg == "--min-time" && i + 1 < argc) bench_min_time = atof(argv[++i]);
+        else {
+            cerr << "Usage: " << argv[0] << " [--json FILE] [--filter SUBSTRING] [--min-time SECONDS]" << endl;
+            return 1;
+        }
+    }
+
+    cout << left << setw(48) << "Benchmark" << right << setw(17) << "Time" << setw(14) << "Iterations" << endl;
+    cout << string(79, '-') << endl;
+
+    run_bench("BM_Enqueue", bm_enqueue);
+    for (size_t backlog : {8, 64, 512, 4096}) {
+        run_bench("BM_SelectHighestUnmasked/" + to_string(backlog), bm_select(backlog, false));
+        run_bench("BM_SelectHighestUnmasked/" + to_string(backlog) + "/keyboard_masked", bm_select(backlog, true));
+    }
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > simd_supported()) continue;
+        for (size_t backlog : {8, 64, 512, 4096}) {
+            string name = string("BM_SelectSoA/") + simd_name(level) + "/" + to_string(backlog);
+            run_bench(name, bm_select_soa(backlog, false, level));
+            run_bench(name + "/keyboard_masked", bm_select_soa(backlog, true, level));
+        }
+    }
+    run_bench("BM_MaskToggle", bm_mask_toggle);
+    run_bench("BM_LogAppend", bm_log_append);
+    run_bench("BM_DispatchThroughput/zero_cost_isr", bm_dispatch_throughput);
+    run_bench("BM_SpscPushPop", bm_spsc_push_pop);
+    run_bench("BM_Timestamp/steady", bm_timestamp(TimeSource::STEADY));
+    if (EventClock(TimeSource::TSC).source() == TimeSource::TSC) run_bench("BM_Timestamp/tsc", bm_timestamp(TimeSource::TSC));
+    for (int producers : {1, 2, 4, 8})
+        run_bench("BM_ConcurrentRaise/" + to_string(producers), bm_concurrent_raise(producers));
+    for (const char *spec : {"uniform", "poisson", "onoff:rate=1000,on=0.01,off=0.1", "periodic:jitter=0.1", "pareto:alpha=1.5"})
+        run_bench(string("BM_ArrivalGap/") + spec, bm_arrival_gap(spec));
+
+    remove(BENCH_LOG);
+
+    if (!json_path.empty()) {
+        write_json(json_path);
+        cout << "Results written to " << json_path << endl;
+    }
+    return 0;
+}
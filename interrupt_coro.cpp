@@ -0,0 +1,205 @@
+/*
+Coroutine device simulator
+Many devices in one process: every device and every multi-step ISR is a C++20
+coroutine (ics/coro.h) instead of a thread, so a device costs one small frame
+rather than a thread stack. Each executor thread runs its own share of the
+devices and its own controller coroutine, which serves pending interrupts by
+policy and awaits the ISR:
+    top half (delay) -> start transfer -> co_await I/O completion -> bottom half (delay)
+
+Build (needs a C++20 compiler; the rest of the project is C++17):
+    cmake --preset release && cmake --build --preset release --target interrupt_coro
+Run:
+    ./interrupt_coro [--devices N] [--rate HZ] [--duration SEC] [--executors N] [--realtime]
+                     [--policy priority|fifo|rr] [--isr TOP,IO,BOTTOM] [--seed N]
+
+Devices are Keyboard, Mouse, Printer in turn, each raising Poisson interrupts at
+--rate per second (default 100000 devices at 1/s). --isr gives the ISR steps in
+microseconds (default 1,2,1). Time is virtual unless --realtime is given.
+*/
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+#include "ics/coro.h"
+#include "ics/interrupt_controller.h"
+#include "ics/rng.h"
+#include "ics/simulation.h"
+
+using namespace std;
+using namespace ics;
+
+struct IsrSteps {
+    int64_t top_ns = 1000;      // acknowledge the device, read its status
+    int64_t io_ns = 2000;       // transfer, awaited as an I/O completion
+    int64_t bottom_ns = 1000;   // hand the data on
+};
+
+// One executor's devices, controller and results; touched only by its own thread
+struct Shard {
+    explicit Shard(Executor::Clock clock) : ex(clock), work(ex) {}
+
+    Executor ex;
+    Completion work;            // set when an interrupt arrives while the controller waits
+    array<deque<int64_t>, DEVICE_SLOTS> pending{}; // raise times per device class, oldest first
+    array<DeviceStats, DEVICE_SLOTS> stats{};
+    int64_t busy_ns = 0;
+
+    void raise(Device d) {
+        pending[d].push_back(ex.now());
+        ++stats[d].arrivals;
+        if (!work.is_set()) work.set();
+    }
+};
+
+Task device(Shard &s, Device d, double rate_hz, uint64_t stream) {
+    for (uint64_t n = 0;; ++n) {
+        double u = (double)(splitmix64(stream + n) >> 11) * 0x1.0p-53;
+        co_await s.ex.delay((int64_t)(-log1p(-u) / rate_hz * 1e9));
+        s.raise(d);
+    }
+}
+
+Task isr(Shard &s, IsrSteps steps) {
+    co_await s.ex.delay(steps.top_ns);
+    Completion io(s.ex);
+    s.ex.complete_after(io, steps.io_ns);
+    co_await io;
+    co_await s.ex.delay(steps.bottom_ns);
+}
+
+Task controller(Shard &s, SchedulingPolicy policy, IsrSteps steps) {
+    Device last_served = PRINTER;
+    for (;;) {
+        bool has[DEVICE_SLOTS] = {};
+        long long age[DEVICE_SLOTS] = {};
+        for (Device d : ALL_DEVICES) {
+            if (s.pending[d].empty()) continue;
+            has[d] = true;
+            age[d] = s.pending[d].front();
+        }
+        int d = choose_device(has, age, policy, last_served);
+        if (!d) {
+            s.work.reset();
+            co_await s.work;
+            continue;
+        }
+        int64_t start = s.ex.now();
+        s.stats[d].latency.record(start - s.pending[d].front());
+        s.pending[d].pop_front();
+        ++s.stats[d].dispatched;
+        co_await isr(s, steps);
+        s.busy_ns += s.ex.now() - start;
+        last_served = (Device)d;
+    }
+}
+
+bool parse_isr_steps(const string &text, IsrSteps &steps) {
+    double top, io, bottom;
+    char tail;
+    if (sscanf(text.c_str(), "%lf,%lf,%lf%c", &top, &io, &bottom, &tail) != 3 || top < 0 || io < 0 || bottom < 0)
+        return false;
+    steps = {(int64_t)(top * 1e3), (int64_t)(io * 1e3), (int64_t)(bottom * 1e3)};
+    return true;
+}
+
+string format_bytes(double bytes) {
+    const char *units[] = {"B", "KB", "MB", "GB", "TB"};
+    int u = 0;
+    while (bytes >= 1024 && u < 4) {
+        bytes /= 1024;
+        ++u;
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.1f %s", bytes, units[u]);
+    return buf;
+}
+
+int main(int argc, char **argv) {
+    long long devices = 100000;
+    double rate_hz = 1, duration_s = 10;
+    unsigned executors = 1;
+    bool realtime = false;
+    SchedulingPolicy policy = SchedulingPolicy::PRIORITY;
+    IsrSteps steps;
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool ok = true;
+        if (arg == "--devices" && i + 1 < argc) ok = (devices = atoll(argv[++i])) > 0;
+        else if (arg == "--rate" && i + 1 < argc) ok = (rate_hz = atof(argv[++i])) > 0;
+        else if (arg == "--duration" && i + 1 < argc) ok = (duration_s = atof(argv[++i])) > 0;
+        else if (arg == "--executors" && i + 1 < argc) ok = (executors = (unsigned)atoi(argv[++i])) > 0;
+        else if (arg == "--realtime") realtime = true;
+        else if (arg == "--policy" && i + 1 < argc) ok = parse_policy(argv[++i], policy);
+        else if (arg == "--isr" && i + 1 < argc) ok = parse_isr_steps(argv[++i], steps);
+        else if (arg == "--seed" && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+        else ok = false;
+        if (!ok) {
+            cerr << "Usage: " << argv[0] << " [--devices N] [--rate HZ] [--duration SEC] [--executors N] [--realtime]\n"
+                 << "       [--policy priority|fifo|rr] [--isr TOP,IO,BOTTOM] [--seed N]" << endl;
+            return 1;
+        }
+    }
+    if (executors > devices) executors = (unsigned)devices;
+
+    Executor::Clock clock = realtime ? Executor::Clock::REAL : Executor::Clock::VIRTUAL;
+    vector<unique_ptr<Shard>> shards;
+    for (unsigned e = 0; e < executors; ++e) {
+        shards.emplace_back(new Shard(clock));
+        Shard &s = *shards.back();
+        s.ex.spawn(controller(s, policy, steps));
+        for (long long i = devices * e / executors; i < devices * (e + 1) / executors; ++i)
+            s.ex.spawn(device(s, ALL_DEVICES[i % 3], rate_hz, splitmix64(seed + (uint64_t)i)));
+    }
+    size_t frames = FrameStats::frames, frame_bytes = FrameStats::bytes;
+
+    cout << "Coroutine executor: " << devices << " devices on " << executors << " executor(s), "
+         << (realtime ? "real" : "virtual") << " time, " << duration_s << " s..." << endl;
+    auto wall0 = chrono::steady_clock::now();
+    vector<thread> threads;
+    int64_t end_ns = (int64_t)llround(duration_s * 1e9);
+    for (auto &s : shards) threads.emplace_back([&s, end_ns] { s->ex.run_until(end_ns); });
+    for (auto &t : threads) t.join();
+    double wall_s = chrono::duration<double>(chrono::steady_clock::now() - wall0).count();
+
+    array<DeviceStats, DEVICE_SLOTS> total{};
+    int64_t busy = 0;
+    uint64_t resumed = 0;
+    for (auto &s : shards) {
+        for (Device d : ALL_DEVICES) total[d].merge(s->stats[d]);
+        busy += s->busy_ns;
+        resumed += s->ex.resumed();
+    }
+    for (Device d : ALL_DEVICES) {
+        const DeviceStats &t = total[d];
+        cout << "  " << left << setw(10) << device_name(d) + ":" << right << t.arrivals << " raised, " << t.dispatched
+             << " dispatched, p50 " << fixed << setprecision(1) << t.latency.quantile(0.5) / 1e3 << " us, p99 "
+             << t.latency.quantile(0.99) / 1e3 << " us, max " << t.latency.max() / 1e3 << " us\n";
+    }
+    cout << "  controller utilization " << setprecision(1) << 100.0 * busy / ((double)end_ns * executors) << "%, "
+         << resumed << " resumptions in " << setprecision(2) << wall_s << " s wall ("
+         << setprecision(0) << resumed / wall_s << "/s)\n";
+    cout << "  coroutine frames: " << frames << " (" << format_bytes((double)frame_bytes) << ", "
+         << frame_bytes / frames << " bytes each)";
+#ifdef __unix__
+    rlimit stack{};
+    if (getrlimit(RLIMIT_STACK, &stack) == 0 && stack.rlim_cur != RLIM_INFINITY)
+        cout << "; a thread per device would reserve " << format_bytes((double)stack.rlim_cur * devices) << " of stack";
+#endif
+    cout << endl;
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+Interrupt generator
+Raises interrupts in a running Interrupt Controller Simulation from a separate
+process, through the simulator's shared-memory ingress ring (ics/shm_ring.h).
+Events carry their raise time, so the simulator measures latency end to end.
+
+Build:
+    cmake --preset release && cmake --build --preset release --target interrupt_gen
+Run:
+    ./interrupt_sim --shm-ingress /ics_ingress          (first)
+    ./interrupt_gen [options]                           (any number of them)
+
+Options:
+    --shm NAME          -- ring name given to --shm-ingress (default /ics_ingress)
+    --arrival D=SPEC    -- raise device D's interrupts with this arrival model (see ics/arrival.h);
+                           one producer thread per device (default k=poisson:rate=1000)
+    --duration SEC      -- stop after SEC seconds (default 10)
+    --flood D           -- ignore arrival models and push device D's interrupts back to back,
+                           to measure ingress throughput
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ics/arrival.h"
+#include "ics/control.h"
+#include "ics/shm_ring.h"
+#include "ics/spin.h"
+
+using namespace std;
+using namespace ics;
+
+// Paced producers yield instead of spinning while the next arrival is this far off
+const int64_t YIELD_AHEAD_NS = 200000;
+
+struct Producer {
+    Device dev;
+    ArrivalSpec spec;
+    uint64_t pushed = 0, full = 0;
+};
+
+void paced_loop(ShmRing &ring, Producer &p, int64_t end_ns, uint64_t seed) {
+    ArrivalProcess arrivals(p.spec, seed);
+    int64_t next = steady_ns() + arrivals.next_gap_ns();
+    while (next < end_ns) {
+        int64_t now = steady_ns();
+        if (now < next) {
+            if (next - now > YIELD_AHEAD_NS) this_thread::yield();
+            else cpu_relax();
+            continue;
+        }
+        if (ring.push(p.dev, now)) ++p.pushed;
+        else ++p.full;
+        next += arrivals.next_gap_ns();
+    }
+}
+
+void flood_loop(ShmRing &ring, Producer &p, int64_t end_ns) {
+    for (;;) {
+        int64_t now = steady_ns();
+        if (now >= end_ns) break;
+        // check the clock once per burst; push() itself is a handful of atomics
+        for (int i = 0; i < 256; ++i) {
+            if (ring.push(p.dev, now)) ++p.pushed;
+            else ++p.full;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    string name = "/ics_ingress";
+    double duration_s = 10;
+    vector<Producer> producers;
+    bool flood = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        Device dev;
+        if (arg == "--shm" && i + 1 < argc) name = argv[++i];
+        else if (arg == "--duration" && i + 1 < argc) duration_s = atof(argv[++i]);
+        else if (arg == "--arrival" && i + 1 < argc) {
+            string text = argv[++i], error;
+            Producer p;
+            if (text.size() < 3 || text[1] != '=' || !parse_device_letter(text.substr(0, 1), p.dev) ||
+                !ArrivalSpec::parse(text.substr(2), p.spec, error)) {
+                cerr << "--arrival " << text << ": " << (error.empty() ? "expects D=SPEC with D one of k|m|p" : error) << endl;
+                return 1;
+            }
+            producers.push_back(p);
+        } else if (arg == "--flood" && i + 1 < argc && parse_device_letter(argv[i + 1], dev)) {
+            ++i;
+            flood = true;
+            Producer p;
+            p.dev = dev;
+            producers.push_back(p);
+        } else {
+            cerr << "Usage: " << argv[0] << " [--shm NAME] [--arrival D=SPEC]... [--duration SEC] [--flood k|m|p]" << endl;
+            return 1;
+        }
+    }
+    if (producers.empty()) {
+        Producer p;
+        p.dev = KEYBOARD;
+        p.spec.kind = ArrivalKind::POISSON;
+        p.spec.rate_hz = 1000;
+        producers.push_back(p);
+    }
+
+    ShmRing ring;
+    string error;
+    if (!ring.attach(name, error)) {
+        cerr << error << endl;
+        return 1;
+    }
+
+    int64_t start = steady_ns();
+    int64_t end = start + (int64_t)(duration_s * 1e9);
+    random_device rd;
+    vector<thread> threads;
+    for (Producer &p : producers) {
+        uint64_t seed = ((uint64_t)rd() << 32) | rd();
+        if (flood) threads.emplace_back(flood_loop, ref(ring), ref(p), end);
+        else threads.emplace_back(paced_loop, ref(ring), ref(p), end, seed);
+    }
+    for (auto &t : threads) t.join();
+    double seconds = (steady_ns() - start) / 1e9;
+
+    uint64_t total = 0;
+    for (const Producer &p : producers) {
+        total += p.pushed;
+        cout << device_name(p.dev) << ": " << p.pushed << " raised, " << p.full << " dropped (ring full)\n";
+    }
+    cout << fixed << setprecision(0) << "Total: " << total / seconds << " interrupts/s over " << setprecision(1)
+         << seconds << " s into " << name << endl;
+    return 0;
+}
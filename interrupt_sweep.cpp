@@ -0,0 +1,327 @@
+/*
+Interrupt Controller Parameter Sweep
+Runs every point of a parameter grid as an independent virtual-time simulation,
+in parallel across all cores, and prints a CSV/JSON matrix of throughput and
+latency percentiles (latency = interrupt arrival to ISR start).
+
+Build:
+    cmake --preset release && cmake --build --preset release --target interrupt_sweep
+Run:
+    ./interrupt_sweep [options]
+
+Options (every grid axis defaults to the console simulator's value):
+    --rate D=R1,R2,...   arrival-rate grid for device D (k|m|p), interrupts/s
+    --isr D=MS1,MS2,...  ISR-cost grid for device D, ms (mean of its service model)
+    --service D=SPEC     ISR service-time model for device D, e.g. k=exp or p=lognormal:sigma=1
+                         (see ics/service.h; --isr still sets its mean)
+    --arrival D=SPEC     arrival model for device D, e.g. k=poisson or p=onoff:on=0.01,off=0.5
+                         (see ics/arrival.h; --rate still sets its mean rate)
+    --mask SET,...       devices masked for the whole run: none, k, mp, ...
+    --policy P,...       scheduling policies: priority, fifo, rr
+    --duration SEC       simulated seconds per point (default 3600)
+    --queue-limit N      max pending interrupts per device; extra arrivals are dropped (default unbounded)
+    --replications R     run R seeds per point and report mean and 95% CI (default 1)
+    --seed N             base seed (default 1); replication r uses seed + r
+    --threads N          worker threads (default: all cores)
+    --format csv|json    output format (default csv)
+    --out FILE           write to FILE instead of stdout
+
+Example: at what Keyboard rate does Printer p99 exceed 5 s?
+    ./interrupt_sweep --rate k=0.5,1,1.5,2,2.5,3 --policy priority,rr
+Confidence intervals over 1000 replications of a simulated hour:
+    ./interrupt_sweep --replications 1000 --queue-limit 8
+*/
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ics/parallel.h"
+#include "ics/replication.h"
+#include "ics/simulation.h"
+
+using namespace std;
+using namespace ics;
+
+struct Axis {
+    string name;
+    vector<double> values;
+};
+
+struct SweepPoint {
+    SimConfig config;
+    string mask;
+};
+
+bool parse_device_letter(char c, Device &d) {
+    if (c == 'k') d = KEYBOARD;
+    else if (c == 'm') d = MOUSE;
+    else if (c == 'p') d = PRINTER;
+    else return false;
+    return true;
+}
+
+vector<string> split(const string &s, char sep) {
+    vector<string> out;
+    stringstream ss(s);
+    string item;
+    while (getline(ss, item, sep)) out.push_back(item);
+    return out;
+}
+
+bool parse_numbers(const string &list, vector<double> &out) {
+    out.clear();
+    for (const string &item : split(list, ',')) {
+        char *end;
+        double v = strtod(item.c_str(), &end);
+        if (item.empty() || *end || v < 0) return false;
+        out.push_back(v);
+    }
+    return !out.empty();
+}
+
+// "k=1,2,3" -> device + values
+bool parse_device_grid(const string &arg, Device &d, vector<double> &values) {
+    return arg.size() > 2 && arg[1] == '=' && parse_device_letter(arg[0], d) && parse_numbers(arg.substr(2), values);
+}
+
+string short_name(Device d) {
+    return d == KEYBOARD ? "k" : d == MOUSE ? "m" : "p";
+}
+
+int usage(const char *prog) {
+    cerr << "Usage: " << prog << " [--rate D=R,...] [--isr D=MS,...] [--arrival D=SPEC] [--service D=SPEC]\n"
+         << "       [--mask SET,...] [--policy P,...]\n"
+         << "       [--duration SEC] [--queue-limit N] [--replications R] [--seed N] [--threads N]\n"
+         << "       [--format csv|json] [--out FILE]" << endl;
+    return 1;
+}
+
+void write_point_header(ostream &out, size_t i, const SweepPoint &pt) {
+    const SimConfig &c = pt.config;
+    out << i << "," << policy_name(c.policy) << "," << pt.mask;
+    for (Device d : ALL_DEVICES) out << "," << c.devices[d].arrival.rate_hz;
+    for (Device d : ALL_DEVICES) out << "," << c.devices[d].service.mean_ms;
+}
+
+void write_csv(ostream &out, const vector<SweepPoint> &points, const vector<SimResult> &results) {
+    out << "point,policy,mask";
+    for (Device d : ALL_DEVICES) out << ",rate_" << short_name(d);
+    for (Device d : ALL_DEVICES) out << ",isr_" << short_name(d) << "_ms";
+    for (Device d : ALL_DEVICES) {
+        string n = device_name(d);
+        out << "," << n << "_throughput," << n << "_p50_ms," << n << "_p95_ms," << n << "_p99_ms," << n << "_max_ms";
+    }
+    out << ",total_throughput,utilization\n";
+    out << setprecision(6);
+    for (size_t i = 0; i < points.size(); ++i) {
+        const SimResult &r = results[i];
+        write_point_header(out, i, points[i]);
+        double total = 0;
+        for (Device d : ALL_DEVICES) {
+            const LatencyHistogram &h = r.devices[d].latency;
+            total += r.throughput(d);
+            out << "," << r.throughput(d) << "," << h.quantile(0.50) / 1e6 << "," << h.quantile(0.95) / 1e6
+                << "," << h.quantile(0.99) / 1e6 << "," << h.max() / 1e6;
+        }
+        out << "," << total << "," << (r.duration_ns ? (double)r.busy_ns / r.duration_ns : 0) << "\n";
+    }
+}
+
+void write_replicated_csv(ostream &out, const vector<SweepPoint> &points, const vector<ReplicationSummary> &sums) {
+    out << "point,policy,mask";
+    for (Device d : ALL_DEVICES) out << ",rate_" << short_name(d);
+    for (Device d : ALL_DEVICES) out << ",isr_" << short_name(d) << "_ms";
+    out << ",replications";
+    for (Device d : ALL_DEVICES) {
+        string n = device_name(d);
+        for (const char *m : {"_throughput", "_p99_ms", "_drop_rate"}) out << "," << n << m << "_mean," << n << m << "_ci95";
+        out << "," << n << "_pooled_p99_ms";
+    }
+    out << ",utilization_mean,utilization_ci95\n";
+    out << setprecision(6);
+    for (size_t i = 0; i < points.size(); ++i) {
+        const ReplicationSummary &s = sums[i];
+        write_point_header(out, i, points[i]);
+        out << "," << s.replications;
+        for (Device d : ALL_DEVICES) {
+            const DeviceSummary &ds = s.devices[d];
+            for (const Estimate &e : {ds.throughput, ds.p99_ms, ds.drop_rate}) out << "," << e.mean << "," << e.ci95;
+            out << "," << ds.pooled.quantile(0.99) / 1e6;
+        }
+        out << "," << s.utilization.mean << "," << s.utilization.ci95 << "\n";
+    }
+}
+
+void write_estimate(ostream &out, const char *name, const Estimate &e) {
+    out << "\"" << name << "\": {\"mean\": " << e.mean << ", \"ci95\": " << e.ci95 << "}";
+}
+
+void write_replicated_json(ostream &out, const vector<SweepPoint> &points, const vector<ReplicationSummary> &sums) {
+    out << "[" << setprecision(6);
+    for (size_t i = 0; i < points.size(); ++i) {
+        const SimConfig &c = points[i].config;
+        const ReplicationSummary &s = sums[i];
+        out << (i ? ",\n" : "\n") << "  {\"point\": " << i << ", \"policy\": \"" << policy_name(c.policy)
+            << "\", \"mask\": \"" << points[i].mask << "\", \"replications\": " << s.replications << ", \"devices\": {";
+        bool first = true;
+        for (Device d : ALL_DEVICES) {
+            const DeviceSummary &ds = s.devices[d];
+            out << (first ? "" : ", ") << "\"" << device_name(d) << "\": {\"arrival\": \"" << c.devices[d].arrival.describe()
+                << "\", \"rate\": " << c.devices[d].arrival.rate_hz
+                << ", \"service\": \"" << c.devices[d].service.describe() << "\", \"isr_ms\": " << c.devices[d].service.mean_ms << ", ";
+            write_estimate(out, "throughput", ds.throughput);
+            out << ", ";
+            write_estimate(out, "p99_ms", ds.p99_ms);
+            out << ", ";
+            write_estimate(out, "drop_rate", ds.drop_rate);
+            out << ", \"pooled_p99_ms\": " << ds.pooled.quantile(0.99) / 1e6 << "}";
+            first = false;
+        }
+        out << "}, ";
+        write_estimate(out, "utilization", s.utilization);
+        out << "}";
+    }
+    out << "\n]\n";
+}
+
+void write_json(ostream &out, const vector<SweepPoint> &points, const vector<SimResult> &results) {
+    out << "[" << setprecision(6);
+    for (size_t i = 0; i < points.size(); ++i) {
+        const SimConfig &c = points[i].config;
+        const SimResult &r = results[i];
+        out << (i ? ",\n" : "\n") << "  {\"point\": " << i << ", \"policy\": \"" << policy_name(c.policy)
+            << "\", \"mask\": \"" << points[i].mask << "\", \"devices\": {";
+        bool first = true;
+        for (Device d : ALL_DEVICES) {
+            const LatencyHistogram &h = r.devices[d].latency;
+            out << (first ? "" : ", ") << "\"" << device_name(d) << "\": {\"arrival\": \"" << c.devices[d].arrival.describe()
+                << "\", \"rate\": " << c.devices[d].arrival.rate_hz
+                << ", \"service\": \"" << c.devices[d].service.describe() << "\", \"isr_ms\": " << c.devices[d].service.mean_ms
+                << ", \"throughput\": " << r.throughput(d)
+                << ", \"arrivals\": " << r.devices[d].arrivals << ", \"dispatched\": " << r.devices[d].dispatched
+                << ", \"p50_ms\": " << h.quantile(0.50) / 1e6 << ", \"p95_ms\": " << h.quantile(0.95) / 1e6
+                << ", \"p99_ms\": " << h.quantile(0.99) / 1e6 << ", \"max_ms\": " << h.max() / 1e6 << "}";
+            first = false;
+        }
+        out << "}, \"utilization\": " << (r.duration_ns ? (double)r.busy_ns / r.duration_ns : 0) << "}";
+    }
+    out << "\n]\n";
+}
+
+int main(int argc, char **argv) {
+    SimConfig base = SimConfig::defaults();
+    base.duration_s = 3600;
+    vector<double> rates[DEVICE_SLOTS], isrs[DEVICE_SLOTS];
+    bool rate_set[DEVICE_SLOTS] = {}, isr_set[DEVICE_SLOTS] = {};
+    for (Device d : ALL_DEVICES) {
+        rates[d] = {base.devices[d].arrival.rate_hz};
+        isrs[d] = {base.devices[d].service.mean_ms};
+    }
+    vector<string> masks = {"none"};
+    vector<SchedulingPolicy> policies = {SchedulingPolicy::PRIORITY};
+    unsigned threads = 0;
+    int replications = 1;
+    string format = "csv", out_path;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 >= argc) return usage(argv[0]);
+        string val = argv[++i];
+        Device d;
+        vector<double> values;
+        string error;
+        if (arg == "--rate" && parse_device_grid(val, d, values)) { rates[d] = values; rate_set[d] = true; }
+        else if (arg == "--arrival" && val.size() > 2 && val[1] == '=' && parse_device_letter(val[0], d)) {
+            if (!ArrivalSpec::parse(val.substr(2), base.devices[d].arrival, error)) {
+                cerr << "--arrival " << val << ": " << error << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--isr" && parse_device_grid(val, d, values)) { isrs[d] = values; isr_set[d] = true; }
+        else if (arg == "--service" && val.size() > 2 && val[1] == '=' && parse_device_letter(val[0], d)) {
+            if (!ServiceSpec::parse(val.substr(2), base.devices[d].service, error)) {
+                cerr << "--service " << val << ": " << error << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--mask") {
+            masks = split(val, ',');
+            for (const string &m : masks)
+                for (char c : m)
+                    if (m != "none" && !parse_device_letter(c, d)) return usage(argv[0]);
+        } else if (arg == "--policy") {
+            policies.clear();
+            for (const string &p : split(val, ',')) {
+                SchedulingPolicy sp;
+                if (!parse_policy(p, sp)) return usage(argv[0]);
+                policies.push_back(sp);
+            }
+        }
+        else if (arg == "--duration") base.duration_s = atof(val.c_str());
+        else if (arg == "--queue-limit") for (Device dv : ALL_DEVICES) base.devices[dv].queue_limit = strtoull(val.c_str(), nullptr, 10);
+        else if (arg == "--replications" && atoi(val.c_str()) > 0) replications = atoi(val.c_str());
+        else if (arg == "--seed") base.seed = strtoull(val.c_str(), nullptr, 10);
+        else if (arg == "--threads") threads = (unsigned)atoi(val.c_str());
+        else if (arg == "--format" && (val == "csv" || val == "json")) format = val;
+        else if (arg == "--out") out_path = val;
+        else return usage(argv[0]);
+    }
+
+    // --arrival/--service models bring their own rate and mean unless --rate/--isr override them
+    for (Device d : ALL_DEVICES) {
+        if (!rate_set[d]) rates[d] = {base.devices[d].arrival.rate_hz};
+        if (!isr_set[d]) isrs[d] = {base.devices[d].service.mean_ms};
+    }
+
+    // cartesian product; the last axis varies fastest
+    vector<SweepPoint> points;
+    for (SchedulingPolicy policy : policies)
+    for (const string &mask : masks)
+    for (double rk : rates[KEYBOARD]) for (double rm : rates[MOUSE]) for (double rp : rates[PRINTER])
+    for (double ik : isrs[KEYBOARD]) for (double im : isrs[MOUSE]) for (double ip : isrs[PRINTER]) {
+        SweepPoint pt{base, mask};
+        pt.config.policy = policy;
+        pt.config.devices[KEYBOARD].arrival.rate_hz = rk;
+        pt.config.devices[MOUSE].arrival.rate_hz = rm;
+        pt.config.devices[PRINTER].arrival.rate_hz = rp;
+        pt.config.devices[KEYBOARD].service.mean_ms = ik;
+        pt.config.devices[MOUSE].service.mean_ms = im;
+        pt.config.devices[PRINTER].service.mean_ms = ip;
+        for (Device d : ALL_DEVICES) pt.config.devices[d].masked = mask.find(short_name(d)) != string::npos;
+        points.push_back(pt);
+    }
+
+    ofstream file;
+    if (!out_path.empty()) {
+        file.open(out_path, ios::trunc);
+        if (!file) {
+            cerr << out_path << ": cannot open" << endl;
+            return 1;
+        }
+    }
+    ostream &out = out_path.empty() ? cout : file;
+
+    if (replications > 1) {
+        vector<SimConfig> configs;
+        for (const SweepPoint &pt : points) configs.push_back(pt.config);
+        vector<ReplicationSummary> sums = replicate(configs, replications, threads);
+        if (format == "json") write_replicated_json(out, points, sums);
+        else write_replicated_csv(out, points, sums);
+        return 0;
+    }
+
+    vector<SimResult> results(points.size());
+    parallel_for(points.size(), threads, [&](size_t i) {
+        Simulation sim(points[i].config);
+        sim.run();
+        results[i] = sim.result();
+    });
+    if (format == "json") write_json(out, points, results);
+    else write_csv(out, points, results);
+    return 0;
+}
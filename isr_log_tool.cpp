@@ -0,0 +1,104 @@
+/*
+ISR log tool
+Reads ISR log segments written by the Interrupt Controller Simulation, whether
+plain text or compressed (.icz).
+
+Build:
+    cmake --preset release && cmake --build --preset release --target isr_log_tool
+Usage:
+    ./isr_log_tool cat FILE...        -- print segments in order (decompressing as needed):
+                                         path.N and path.N.icz by N, then the active path,
+                                         whatever order the shell's glob gave them in;
+                                         raw-time segments (interrupt_sim --tsc) get their
+                                         steady-clock times converted to wall time
+    ./isr_log_tool compress FILE      -- write FILE.icz
+*/
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ics/isr_log.h"
+#include "ics/log_codec.h"
+
+using namespace std;
+using namespace ics;
+
+int usage(const char *prog) {
+    cerr << "Usage: " << prog << " cat FILE... | compress FILE" << endl;
+    return 2;
+}
+
+// Copies a segment to out, converting raw times after the segment's clock anchor
+void print_segment(istream &in, ostream &out) {
+    string line;
+    bool anchored = false;
+    int64_t steady_ns = 0, wall_ns = 0;
+    while (getline(in, line)) {
+        if (parse_clock_anchor(line, steady_ns, wall_ns)) anchored = true;
+        else if (anchored) line = raw_time_to_wall(line, steady_ns, wall_ns);
+        out << line << "\n";
+    }
+}
+
+// "isr_log.txt.12.icz" -> {"isr_log.txt", 12}; the active file sorts after its segments
+pair<string, long> segment_key(const string &path) {
+    string name = path;
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".icz") == 0) name.resize(name.size() - 4);
+    size_t dot = name.rfind('.');
+    if (dot != string::npos && dot + 1 < name.size()) {
+        char *end;
+        long n = strtol(name.c_str() + dot + 1, &end, 10);
+        if (!*end) return {name.substr(0, dot), n};
+    }
+    return {path, LONG_MAX};
+}
+
+bool cat_file(const string &path) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        cerr << path << ": cannot open" << endl;
+        return false;
+    }
+    if (log_codec::is_compressed(in)) {
+        stringstream plain;
+        if (!log_codec::decompress_stream(in, plain)) {
+            cerr << path << ": corrupt compressed segment" << endl;
+            return false;
+        }
+        print_segment(plain, cout);
+    } else {
+        print_segment(in, cout);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) return usage(argv[0]);
+    string cmd = argv[1];
+    if (cmd == "cat") {
+        vector<string> paths(argv + 2, argv + argc);
+        stable_sort(paths.begin(), paths.end(),
+                    [](const string &a, const string &b) { return segment_key(a) < segment_key(b); });
+        bool ok = true;
+        for (const string &path : paths) ok = cat_file(path) && ok;
+        return ok ? 0 : 1;
+    }
+    if (cmd == "compress" && argc == 3) {
+        string path = argv[2];
+        ifstream in(path, ios::binary);
+        ofstream out(path + ".icz", ios::binary | ios::trunc);
+        if (!in || !out || !log_codec::compress_stream(in, out)) {
+            cerr << path << ": compression failed" << endl;
+            return 1;
+        }
+        return 0;
+    }
+    return usage(argv[0]);
+}
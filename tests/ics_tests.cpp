@@ -0,0 +1,258 @@
+/*
+Regression tests for the ics library: checkpoint round trips, the log codec,
+scenario parsing and the SIMD selection kernels.
+
+Build and run:
+    cmake --preset release && cmake --build --preset release && ctest --test-dir build/release
+or one group directly:
+    ./ics_tests [checkpoint|codec|scenario|select]
+
+Each group prints one line per failed check and exits 1 if any failed.
+*/
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "ics/checkpoint.h"
+#include "ics/interrupt_controller.h"
+#include "ics/log_codec.h"
+#include "ics/pending_queue.h"
+#include "ics/scenario.h"
+#include "ics/simulation.h"
+
+using namespace std;
+using namespace ics;
+
+static int failures = 0;
+
+#define CHECK(cond, what)                                                              \
+    do {                                                                               \
+        if (!(cond)) {                                                                 \
+            cerr << __FILE__ << ":" << __LINE__ << ": " << what << endl;               \
+            ++failures;                                                                \
+        }                                                                              \
+    } while (0)
+
+static string temp_path(const string &name) {
+    return (filesystem::temp_directory_path() / ("ics_tests_" + to_string(getpid()) + "_" + name)).string();
+}
+
+static string state_of(const Simulation &sim) {
+    BinWriter w;
+    sim.save(w);
+    return w.data();
+}
+
+// --- checkpoint: save -> load -> run continues exactly like the uninterrupted run
+
+static void test_checkpoint() {
+    SimConfig config = SimConfig::defaults();
+    config.duration_s = 120;
+    config.seed = 7;
+    string error;
+    // busy enough that queues build up and the mouse drops: more state to get wrong
+    CHECK(ArrivalSpec::parse("poisson:rate=40", config.devices[KEYBOARD].arrival, error), error);
+    CHECK(ArrivalSpec::parse("poisson:rate=20", config.devices[MOUSE].arrival, error), error);
+    config.devices[MOUSE].queue_limit = 4;
+
+    Simulation whole(config);
+    whole.run_until(30000000000LL);
+    whole.set_mask(PRINTER, true);
+    whole.set_tpr(1);
+    whole.run_until(60000000000LL);
+
+    string path = temp_path("round_trip.ckpt");
+    CHECK(save_checkpoint(whole, path, error), "save_checkpoint: " << error);
+    Simulation resumed(config);
+    CHECK(load_checkpoint(path, resumed, error), "load_checkpoint: " << error);
+    CHECK(state_of(resumed) == state_of(whole), "loaded state differs from the saved one");
+
+    whole.run();
+    resumed.run();
+    CHECK(state_of(resumed) == state_of(whole), "resumed run diverged from the uninterrupted one");
+    SimResult a = whole.result(), b = resumed.result();
+    for (Device d : ALL_DEVICES) {
+        CHECK(a.devices[d].arrivals == b.devices[d].arrivals, device_name(d) << " arrivals differ");
+        CHECK(a.devices[d].dispatched == b.devices[d].dispatched, device_name(d) << " dispatches differ");
+        CHECK(a.devices[d].latency.max() == b.devices[d].latency.max(), device_name(d) << " max latency differs");
+    }
+    CHECK(a.devices[MOUSE].dropped > 0, "no drops: the run is too light to exercise the queues");
+
+    // a truncated file is rejected and leaves the target untouched
+    {
+        ifstream in(path, ios::binary);
+        string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        ofstream(path, ios::binary | ios::trunc).write(bytes.data(), (streamsize)bytes.size() / 2);
+    }
+    Simulation fresh(config);
+    string before = state_of(fresh);
+    CHECK(!load_checkpoint(path, fresh, error), "truncated checkpoint accepted");
+    CHECK(state_of(fresh) == before, "rejected checkpoint modified the simulation");
+    remove(path.c_str());
+}
+
+// --- log codec: round trips and rejection of damaged streams
+
+static string compress(const string &plain) {
+    istringstream in(plain);
+    ostringstream out;
+    log_codec::compress_stream(in, out);
+    return out.str();
+}
+
+static bool decompress(const string &packed, string &plain) {
+    istringstream in(packed);
+    ostringstream out;
+    bool ok = log_codec::decompress_stream(in, out);
+    plain = out.str();
+    return ok;
+}
+
+static string block_header(uint32_t raw_len, uint32_t stored_len) {
+    string h(log_codec::MAGIC, 4);
+    log_codec::put_u32(h, raw_len);
+    log_codec::put_u32(h, stored_len);
+    return h;
+}
+
+static void test_codec() {
+    mt19937 gen(3);
+    string text, noise;
+    for (int i = 0; text.size() < 3 * log_codec::BLOCK_SIZE + 123; ++i)
+        text += "[" + to_string(i * 1250) + " us] ISR: keyboard interrupt " + to_string(i) + " handled\n";
+    for (int i = 0; i < 70000; ++i) noise.push_back((char)gen());
+
+    for (const string &plain : {string(), string("x"), string("abcd abcd abcd abcd"), text, noise}) {
+        string packed = compress(plain), back;
+        CHECK(decompress(packed, back) && back == plain, "round trip of " << plain.size() << " bytes failed");
+    }
+    CHECK(compress(text).size() < text.size() / 2, "log text did not compress");
+
+    // every truncation of a multi-block stream is rejected
+    string packed = compress(text.substr(0, 2 * log_codec::BLOCK_SIZE + 500)), back;
+    for (size_t cut = 0; cut < packed.size(); cut += cut < 64 ? 1 : 997)
+        CHECK(!decompress(packed.substr(0, cut), back), "stream truncated to " << cut << " bytes accepted");
+
+    // headers that claim more than the encoder can produce fail before anything is allocated
+    CHECK(!decompress(block_header(10, 0x7fffffffu), back), "oversized stored_len accepted");
+    CHECK(!decompress(block_header(10, 0x7fffffffu | log_codec::STORED_RAW), back), "oversized raw block accepted");
+    CHECK(!decompress(block_header(log_codec::BLOCK_SIZE + 1, 4), back), "raw_len over BLOCK_SIZE accepted");
+    CHECK(!decompress(block_header(4, 3 | log_codec::STORED_RAW) + "abc", back), "raw block length mismatch accepted");
+
+    // a match that would expand past raw_len is rejected
+    string block;
+    log_codec::emit_record(block, "ab", 2, 200, 2);
+    log_codec::emit_record(block, "", 0, 0, 0);
+    string bomb = block_header(8, (uint32_t)block.size()) + block;
+    log_codec::put_u32(bomb, 0);
+    log_codec::put_u32(bomb, 0);
+    CHECK(!decompress(bomb, back), "block expanding past raw_len accepted");
+}
+
+// --- scenario parse errors carry the line number and the reason
+
+static void expect_parse_error(const string &text, const string &expected) {
+    istringstream in(text);
+    Scenario s;
+    string error;
+    bool ok = Scenario::parse(in, s, error);
+    CHECK(!ok, "accepted: " << text);
+    CHECK(error.find(expected) != string::npos, "error '" << error << "' lacks '" << expected << "'");
+}
+
+static void test_scenario() {
+    istringstream good("# comment\nduration 20s\narrival k poisson:rate=5\npolicy fifo\n"
+                       "at 5s mask p\nat 12s set-rate k 5\nexpect k p99 < 50ms\n");
+    Scenario s;
+    string error;
+    CHECK(Scenario::parse(good, s, error), "valid scenario rejected: " << error);
+    CHECK(s.events.size() == 2 && s.expectations.size() == 1 && s.has_policy, "valid scenario misparsed");
+
+    expect_parse_error("duration 0s\n", "line 1: duration expects a positive time");
+    expect_parse_error("duration 5s\nfrobnicate\n", "line 2: unknown directive 'frobnicate'");
+    expect_parse_error("at soon mask p\n", "line 1: at expects a time");
+    expect_parse_error("at 1s mask z\n", "line 1: mask expects k|m|p");
+    expect_parse_error("at 1s set-rate k -3\n", "line 1: set-rate: rate must be a positive number");
+    expect_parse_error("at 1s tpr 99\n", "line 1: tpr expects a level");
+    expect_parse_error("at 1s reboot\n", "line 1: unknown command 'reboot'");
+    expect_parse_error("policy random\n", "line 1: policy expects priority|fifo|rr");
+    expect_parse_error("arrival q poisson:rate=5\n", "line 1: arrival expects k|m|p SPEC");
+    expect_parse_error("expect k p42 < 5ms\n", "line 1: unknown metric 'p42'");
+    expect_parse_error("expect k p99 == 5ms\n", "line 1: operator must be");
+    expect_parse_error("expect k throughput > lots\n", "line 1: bound must be a number");
+    expect_parse_error("duration 5s\nat 6s mask p\n", "line 2: command after the end of the scenario");
+    expect_parse_error("at 11s mask p\n", "command after the default 10s duration");
+}
+
+// --- select_next: every SIMD level picks what the vector reference picks
+
+static void test_select() {
+    mt19937 gen(11);
+    uniform_int_distribution<> dev(PRINTER, KEYBOARD);
+    MaskRegister masks{};
+    SimdLevel saved = simd_level();
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > simd_supported()) {
+            cout << "select: " << simd_name(level) << " not supported here, skipped" << endl;
+            continue;
+        }
+        set_simd_level(level);
+        for (size_t backlog : {0, 1, 3, 7, 8, 9, 15, 16, 17, 31, 64, 100, 257, 1000}) {
+            vector<InterruptEvent> events;
+            PendingQueue pending;
+            long long count[DEVICE_SLOTS] = {};
+            for (size_t i = 0; i < backlog; ++i) {
+                Device d = (Device)dev(gen);
+                InterruptEvent ev{d, device_seq(d, ++count[d]), chrono::steady_clock::now()};
+                events.push_back(ev);
+                pending.push_back(ev);
+            }
+            // erase() reorders the queue; selection must not depend on order
+            if (backlog > 2) {
+                pending.erase(1);
+                events.erase(events.begin() + 1);
+                events.insert(events.begin() + 1, events.back());
+                events.pop_back();
+            }
+            for (int mask_bits = 0; mask_bits < 8; ++mask_bits) {
+                for (Device d : ALL_DEVICES) masks[d] = (mask_bits >> (d - 1)) & 1;
+                for (SchedulingPolicy policy : {SchedulingPolicy::PRIORITY, SchedulingPolicy::FIFO, SchedulingPolicy::ROUND_ROBIN})
+                    for (Device last : ALL_DEVICES)
+                        for (int tpr = 0; tpr <= KEYBOARD; ++tpr) {
+                            int want = select_next(events, masks, policy, last, tpr);
+                            int got = select_next(pending, masks, policy, last, tpr);
+                            CHECK(got == want, simd_name(level) << " picked " << got << " instead of " << want
+                                                              << " (backlog " << backlog << ", masks " << mask_bits
+                                                              << ", " << policy_name(policy) << ", tpr " << tpr << ")");
+                        }
+            }
+        }
+    }
+    set_simd_level(saved);
+}
+
+int main(int argc, char *argv[]) {
+    const pair<const char *, void (*)()> groups[] = {
+        {"checkpoint", test_checkpoint}, {"codec", test_codec}, {"scenario", test_scenario}, {"select", test_select}};
+    string only = argc > 1 ? argv[1] : "";
+    bool ran = false;
+    for (const auto &g : groups) {
+        if (!only.empty() && only != g.first) continue;
+        g.second();
+        ran = true;
+    }
+    if (!ran) {
+        cerr << "Usage: " << argv[0] << " [checkpoint|codec|scenario|select]" << endl;
+        return 2;
+    }
+    if (failures) cerr << failures << " check(s) failed" << endl;
+    return failures ? 1 : 0;
+}